@@ -1,4 +1,5 @@
 #include "bus.h"
+#include "profiler.h"
 #include <iostream>
 #include <iomanip>
 #include <sstream>
@@ -7,9 +8,10 @@
 // Initialize static member
 std::ofstream Bus::debugFile;
 
-Bus::Bus(uint64_t &cycle) : globalCycle(cycle), debugMode(false), isBusy(false), remainingCycles(0), currentRequestingCore(-1)
+Bus::Bus(uint64_t &cycle)
+    : globalCycle(cycle), debugMode(false), isBusy(false), remainingCycles(0), currentRequestingCore(-1),
+      currentType(BusTransactionType::BusRd), servingUpgrade(false), coreBusyCycles()
 {
-    resetStats();
     // Open debug file once at initialization
     debugFile.open("debug.txt", std::ios::out | std::ios::app); // Use append mode instead of truncate
 }
@@ -29,40 +31,44 @@ void Bus::debugPrint(const std::string &msg) const
     debugFile << "[Bus Cycle " << globalCycle << "] " << msg << std::endl;
 }
 
-void Bus::resetStats()
-{
-    stats = BusStats{};
-}
-
 void Bus::registerCache(Cache &cache)
 {
     caches.push_back(std::ref(cache));
+    coreBusyCycles.push_back(0);
     debugPrint("New cache registered with the bus");
 }
 
 void Bus::updateBusState()
 {
+    stats.elapsedCycles++;
     if (isBusy)
     {
+        // The bus was held for the whole cycle that just ended
+        stats.busyCycles++;
+        stats.typeBusyCycles[static_cast<int>(currentType)]++;
+        coreBusyCycles[currentRequestingCore]++;
+
         remainingCycles--;
         if (remainingCycles <= 0)
         {
             isBusy = false;
             currentRequestingCore = -1;
+            servingUpgrade = false;
             debugPrint("Bus transaction completed");
         }
     }
 }
 
-void Bus::addRemainingCycles(long long int cycles, long long int coreId)
+bool Bus::addRemainingCycles(long long int cycles, long long int coreId)
 {
     remainingCycles += cycles;
-    if(isBusy) return;
+    if(isBusy) return true;
     isBusy = true;
     currentRequestingCore = coreId;
+    return true;
 }
 
-bool Bus::broadcastTransaction(BusTransactionType type, uint32_t address, long long int requestingCore)
+bool Bus::broadcastTransaction(BusTransactionType type, uint64_t address, long long int requestingCore)
 {
     // If bus is busy, transaction cannot be processed
     if (isBusy && currentRequestingCore != requestingCore)
@@ -78,6 +84,8 @@ bool Bus::broadcastTransaction(BusTransactionType type, uint32_t address, long l
     // Set bus as busy and mark the requesting core
     isBusy = true;
     currentRequestingCore = requestingCore;
+    currentType = type;
+    servingUpgrade = (type == BusTransactionType::BusUpgr);
 
     // Note: We no longer set remaining cycles here
     // The cache will set the appropriate cycle count during processTransaction
@@ -88,6 +96,7 @@ bool Bus::broadcastTransaction(BusTransactionType type, uint32_t address, long l
 
 bool Bus::processTransaction(const BusTransaction &transaction)
 {
+    PROFILE_SCOPE(ProfilePhase::Snoop);
     // Update statistics based on transaction type
     stats.totalTransactions++;
     switch (transaction.type)
@@ -150,11 +159,6 @@ bool Bus::processTransaction(const BusTransaction &transaction)
     return dataFromOtherCache;
 }
 
-const BusStats &Bus::getStats() const
-{
-    return stats;
-}
-
 void Bus::printStats(std::ostream& out) const
 {
     out << "\nBus Statistics:\n";
@@ -164,3 +168,26 @@ void Bus::printStats(std::ostream& out) const
     out << "BusUpgr Transactions: " << stats.busUpgrTransactions << "\n";
     out << "Total Bus Traffic (Bytes): " << stats.totalBusTraffic << "\n";
 }
+
+void Bus::printCostBreakdown(std::ostream &out) const
+{
+    static const char *typeNames[busTransactionTypeCount] = {"BusRd", "BusRdX", "BusUpgr"};
+    uint64_t busy = stats.busyCycles;
+    out << "\nBus Cost Breakdown:\n";
+    out << "Bus Busy Cycles: " << busy << " of " << stats.elapsedCycles << "\n";
+    out << "Bus Utilization: " << std::fixed << std::setprecision(2)
+        << (stats.elapsedCycles > 0 ? 100.0 * busy / stats.elapsedCycles : 0.0) << "%\n";
+    out << "Busy Cycles by Transaction Type:\n";
+    for (int t = 0; t < busTransactionTypeCount; ++t)
+    {
+        out << "  " << typeNames[t] << ": " << stats.typeBusyCycles[t] << " (" << std::fixed << std::setprecision(2)
+            << (busy > 0 ? 100.0 * stats.typeBusyCycles[t] / busy : 0.0) << "%)\n";
+    }
+    out << "Busy Cycles by Requesting Core:\n";
+    for (size_t core = 0; core < coreBusyCycles.size(); ++core)
+    {
+        out << "  Core " << core << ": " << coreBusyCycles[core] << " (" << std::fixed << std::setprecision(2)
+            << (busy > 0 ? 100.0 * coreBusyCycles[core] / busy : 0.0) << "%)\n";
+    }
+    Interconnect::printCostBreakdown(out);
+}
@@ -6,35 +6,10 @@
 #include <string>
 #include <fstream>
 #include "cache.h"
+#include "interconnect.h"
 
-// Bus transaction types for MESI protocol
-enum class BusTransactionType
-{
-    BusRd,   // Bus Read - Request for shared copy
-    BusRdX,  // Bus Read Exclusive - Request for exclusive copy
-    BusUpgr, // Bus Upgrade - Request to upgrade to exclusive
-};
-
-// Bus transaction structure
-struct BusTransaction
-{
-    BusTransactionType type;
-    uint32_t address;
-    long long int requestingCore;
-    uint64_t timestamp;
-};
-
-// Bus statistics
-struct BusStats
-{
-    uint64_t totalTransactions;
-    uint64_t busRdTransactions;
-    uint64_t busRdXTransactions;
-    uint64_t busUpgrTransactions;
-    uint64_t totalBusTraffic;
-};
-
-class Bus
+// Central snooping bus: one atomic transaction at a time, broadcast to every cache
+class Bus : public Interconnect
 {
 private:
     std::vector<std::reference_wrapper<Cache>> caches; // Store references to Cache objects
@@ -43,6 +18,9 @@ private:
     bool isBusy;                         // Flag to indicate if bus is currently busy
     long long int remainingCycles;       // Number of cycles remaining for current transaction
     long long int currentRequestingCore; // Core that currently has the bus
+    BusTransactionType currentType;      // Type of the transaction holding the bus
+    bool servingUpgrade;                 // The bus is held by a BusUpgr, whose store has already retired
+    std::vector<uint64_t> coreBusyCycles; // Cycles the bus was held per requesting core
     static std::ofstream debugFile;      // Static file stream for debug output
 
     void debugPrint(const std::string &msg) const;
@@ -50,19 +28,25 @@ private:
 public:
     Bus(uint64_t &cycle);
     ~Bus(); // Add destructor to close debug file
-    void setDebugMode(bool enable) { debugMode = enable; }
-    BusStats stats;
+    void setDebugMode(bool enable) override { debugMode = enable; }
     // Core bus operations
-    void registerCache(Cache &cache); // Take a reference
-    bool broadcastTransaction(BusTransactionType type, uint32_t address, long long int requestingCore);
+    void registerCache(Cache &cache) override; // Take a reference
+    bool broadcastTransaction(BusTransactionType type, uint64_t address, long long int requestingCore) override;
     bool processTransaction(const BusTransaction &transaction);
-    void updateBusState();                         // New method to update bus state each cycle
-    void addRemainingCycles(long long int cycles, long long int coreId); // New method to set remaining cycles
+    void updateBusState() override;                         // New method to update bus state each cycle
+    bool addRemainingCycles(long long int cycles, long long int coreId) override; // New method to set remaining cycles
+
+    bool isServing(long long int core) const override { return isBusy && currentRequestingCore == core; }
+    bool canIssue(long long int) const override { return !isBusy; }
+    bool missCompleting(long long int core) const override
+    {
+        return remainingCycles == 1 && currentRequestingCore == core && !servingUpgrade;
+    }
 
     // Statistics
-    const BusStats &getStats() const;
-    void resetStats();
-    void printStats(std::ostream& out = std::cout) const;
+    std::string describe() const override { return "Central snooping bus"; }
+    void printStats(std::ostream& out = std::cout) const override;
+    void printCostBreakdown(std::ostream &out) const override;
 
     // Helper methods
     uint64_t getCurrentCycle() const { return globalCycle; }
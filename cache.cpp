@@ -1,10 +1,14 @@
 #include "cache.h"
-#include "bus.h"
+#include "interconnect.h"
+#include "prefetcher.h"
+#include "heatmap.h"
+#include "snapshot.h"
 #include <iostream>
 #include <iomanip>
 #include <cmath>
 #include <sstream>
 #include <fstream>
+#include <cstdlib>
 
 // Initialize static member
 std::ofstream Cache::debugFile;
@@ -24,13 +28,20 @@ void Cache::debugPrint(const std::string &msg) const
 
 Cache::Cache(uint32_t setIndexBits, uint32_t associativity, uint32_t blockBits, long long int id, uint64_t &cycle)
     : numSets(0), associativity(associativity), blockSize(0), setIndexBits(setIndexBits),
-      blockBits(blockBits), tagBits(0), sets(), globalCycle(cycle), debugMode(false),
-      bus(nullptr), cacheId(id), stats()
+      blockBits(blockBits), tagBits(0), sets(), tagRegions(), tagRegionIndex(), freeTagRegions(),
+      tagRegionLimit(UINT16_MAX + 1), globalCycle(cycle), lruBase(0), debugMode(false),
+      bus(nullptr), cacheId(id), mshrCount(0), mshrs(),
+      prefetcher(nullptr), prefetchQueue(), prefetchInFlight(false), prefetchLateCounted(false), prefetchBlock(0),
+      storeBufferDepth(0), storeBufferTSO(false), storeBuffer(), storeDrainInFlight(false), heatMap(nullptr),
+      victimCacheSize(0), victimCache(), wayPrediction(false),
+      lookupPredicted(false), lookupTagChecks(0), activeThread(0), threadEvictions(), stats()
 {
     // Calculate number of sets and block size
     numSets = 1 << setIndexBits;
     blockSize = 1 << blockBits;
-    tagBits = 32 - setIndexBits - blockBits;
+    tagBits = 64 - setIndexBits - blockBits;
+    tagRegions.push_back(0); // Region 0: addresses below 2^(32 + s + b)
+    tagRegionIndex[0] = 0;
 
     // Initialize cache sets and lines
     sets.resize(numSets);
@@ -38,11 +49,18 @@ Cache::Cache(uint32_t setIndexBits, uint32_t associativity, uint32_t blockBits,
     {
         sets[i].lines.resize(associativity);
         sets[i].accessCount = 0;
+        sets[i].missCount = 0;
+        sets[i].evictionCount = 0;
+        sets[i].invalidationCount = 0;
+        sets[i].predictedWay = 0;
         for (uint32_t j = 0; j < associativity; ++j)
         {
             sets[i].lines[j].tag = 0;
+            sets[i].lines[j].tagRegion = 0;
             sets[i].lines[j].state = CacheState::INVALID;
+            sets[i].lines[j].prefetched = false;
             sets[i].lines[j].lastAccessTime = 0;
+            sets[i].lines[j].thread = noThread;
             sets[i].lines[j].data.clear();
         }
     }
@@ -71,24 +89,131 @@ void Cache::resetStats()
     stats.busTrafficBytes = 0;
     stats.idleCycles = 0;
     stats.totalCycles = 0;
+    stats.mshrMergedMisses = 0;
+    stats.mshrStallCycles = 0;
+    stats.mshrOccupancySum = 0;
+    stats.mshrOccupancyPeak = 0;
+    stats.mshrSampledCycles = 0;
+    stats.prefetchIssued = 0;
+    stats.prefetchUseful = 0;
+    stats.prefetchLate = 0;
+    stats.prefetchUnused = 0;
+    stats.prefetchInvalidations = 0;
+    stats.sbCoalesced = 0;
+    stats.sbForwarded = 0;
+    stats.sbStallCycles = 0;
+    stats.sbDrained = 0;
+    stats.sbOccupancyPeak = 0;
+    stats.victimHits = 0;
+    stats.victimEvictions = 0;
+    stats.wayPredLookups = 0;
+    stats.wayPredHits = 0;
+    stats.tagChecks = 0;
 }
 
-uint32_t Cache::getSetIndex(uint32_t address)
+uint32_t Cache::getSetIndex(uint64_t address)
 {
     // Extract the set index bits from the address
-    return (address >> blockBits) & ((1 << setIndexBits) - 1);
+    return static_cast<uint32_t>((address >> blockBits) & ((1ULL << setIndexBits) - 1));
 }
 
-uint32_t Cache::getTag(uint32_t address)
+uint64_t Cache::getTag(uint64_t address)
 {
     // Extract the tag bits from the address
     return address >> (setIndexBits + blockBits);
 }
 
-uint32_t Cache::getBlockOffset(uint32_t address)
+uint32_t Cache::getBlockOffset(uint64_t address)
 {
     // Extract the block offset bits from the address
-    return address & ((1 << blockBits) - 1);
+    return static_cast<uint32_t>(address & ((1ULL << blockBits) - 1));
+}
+
+void Cache::setLineTag(CacheLine &line, uint64_t tag)
+{
+    // Programs touch only a handful of distinct upper tag values, so they are
+    // kept once per cache and each line stores an index into the table
+    uint64_t upper = tag >> 32;
+    uint32_t region = line.tagRegion;
+    if (tagRegions[region] != upper)
+    {
+        std::unordered_map<uint64_t, uint32_t>::const_iterator it = tagRegionIndex.find(upper);
+        if (it != tagRegionIndex.end())
+        {
+            region = it->second;
+        }
+        else
+        {
+            if (freeTagRegions.empty() && tagRegions.size() >= tagRegionLimit)
+            {
+                recycleTagRegions();
+            }
+            if (!freeTagRegions.empty())
+            {
+                region = freeTagRegions.back();
+                freeTagRegions.pop_back();
+                tagRegions[region] = upper;
+            }
+            else
+            {
+                region = static_cast<uint32_t>(tagRegions.size());
+                tagRegions.push_back(upper);
+            }
+            tagRegionIndex[upper] = region;
+        }
+    }
+    line.tag = static_cast<uint32_t>(tag);
+    line.tagRegion = region;
+}
+
+void Cache::recycleTagRegions()
+{
+    // A trace sweeping many distinct upper tag values would grow the table
+    // without bound. Regions no valid line refers to any more are freed; the
+    // limit doubles when fewer than half could be freed, so the table stays
+    // within about twice the number of lines and the scans stay rare.
+    std::vector<bool> used(tagRegions.size(), false);
+    used[0] = true;
+    for (uint32_t s = 0; s < numSets; ++s)
+    {
+        for (const CacheLine &line : sets[s].lines)
+        {
+            if (line.state != CacheState::INVALID)
+                used[line.tagRegion] = true;
+        }
+    }
+    for (const VictimEntry &entry : victimCache)
+    {
+        if (entry.line.state != CacheState::INVALID)
+            used[entry.line.tagRegion] = true;
+    }
+
+    // Invalid lines may still point at a freed region; their tags no longer matter
+    for (uint32_t s = 0; s < numSets; ++s)
+    {
+        for (CacheLine &line : sets[s].lines)
+        {
+            if (!used[line.tagRegion])
+                line.tagRegion = 0;
+        }
+    }
+    for (VictimEntry &entry : victimCache)
+    {
+        if (!used[entry.line.tagRegion])
+            entry.line.tagRegion = 0;
+    }
+    for (uint32_t region = static_cast<uint32_t>(tagRegions.size()); region-- > 1;)
+    {
+        if (!used[region])
+        {
+            tagRegionIndex.erase(tagRegions[region]);
+            freeTagRegions.push_back(region);
+        }
+    }
+    if (freeTagRegions.size() * 2 < tagRegions.size())
+    {
+        tagRegionLimit *= 2;
+    }
 }
 
 long long int Cache::findLRULine(long long int setIndex)
@@ -115,10 +240,11 @@ long long int Cache::findLRULine(long long int setIndex)
 void Cache::updateLRU(long long int setIndex, long long int lineIndex)
 {
     // Update the lastAccessTime for the accessed line to the current cycle
-    sets[setIndex].lines[lineIndex].lastAccessTime = globalCycle;
+    sets[setIndex].lines[lineIndex].lastAccessTime = lruBase + globalCycle;
+    sets[setIndex].predictedWay = static_cast<uint32_t>(lineIndex);
 }
 
-void Cache::writeBackToMemory(long long int setIndex, long long int lineIndex)
+void Cache::writeBackToMemory(CacheLine &line)
 {
     stats.writebackCount++;
     stats.busTrafficBytes += blockSize;
@@ -126,115 +252,78 @@ void Cache::writeBackToMemory(long long int setIndex, long long int lineIndex)
     // Use the bus to write back to memory
     if (bus)
     {
-        bus->addRemainingCycles(100, cacheId);
+        bus->charge(BusCycleSource::Writeback, cacheId);
     }
 
-    sets[setIndex].lines[lineIndex].dirty = false;
+    line.dirty = false;
 }
 
-bool Cache::processBusTransaction(uint32_t address, bool isWrite, long long int requestingCore, bool data_requested)
+bool Cache::processBusTransaction(uint64_t address, bool isWrite, long long int requestingCore, bool data_requested)
 {
     if (requestingCore == cacheId)
         return false; // Don't process our own transactions
     uint32_t setIndex = getSetIndex(address);
-    uint32_t tag = getTag(address);
 
-    // Search for the line in the set
-    for (uint32_t i = 0; i < associativity; ++i)
-    {
-        CacheLine &line = sets[setIndex].lines[i];
+    // The block may sit in its set or in the victim cache
+    CacheLine *found = findLine(address);
+    if (!found)
+        return false; // We don't have the data
 
-        if (line.tag == tag && line.state != CacheState::INVALID)
+    CacheLine &line = *found;
+    if (isWrite)
+    {
+        // Invalidate the line if it's a write transaction (BusRdX or BusUpgr)
+        if (line.state == CacheState::MODIFIED)
         {
-            if (isWrite)
+            writeBackToMemory(line);
+        }
+        line.state = CacheState::INVALID;
+        if (heatMap)
+        {
+            sets[setIndex].invalidationCount++;
+            heatMap->record(HeatEvent::Invalidation, address >> blockBits);
+        }
+        if (line.prefetched)
+        {
+            // Prefetched copy of shared data killed before we ever used it
+            stats.prefetchInvalidations++;
+            stats.prefetchUnused++;
+            line.prefetched = false;
+        }
+        debugPrint("  Line invalidated due to bus write transaction");
+    }
+    else
+    {
+        // For read transactions (BusRd), transition to SHARED state if in EXCLUSIVE or MODIFIED
+        if (line.state == CacheState::EXCLUSIVE || line.state == CacheState::MODIFIED)
+        {
+            if (line.state == CacheState::MODIFIED)
             {
-                // Invalidate the line if it's a write transaction (BusRdX or BusUpgr)
-                if (line.state == CacheState::MODIFIED)
-                {
-                    writeBackToMemory(setIndex, i);
-                }
-                line.state = CacheState::INVALID;
-                debugPrint("  Line invalidated due to bus write transaction");
+                // If modified, need to write back first
+                writeBackToMemory(line);
             }
-            else
-            {
-                // For read transactions (BusRd), transition to SHARED state if in EXCLUSIVE or MODIFIED
-                if (line.state == CacheState::EXCLUSIVE || line.state == CacheState::MODIFIED)
-                {
-                    if (line.state == CacheState::MODIFIED)
-                    {
-                        // If modified, need to write back first
-                        writeBackToMemory(setIndex, i);
-                    }
-                    line.state = CacheState::SHARED;
-                    debugPrint("  Line transitioned to SHARED due to bus read transaction");
-                }
-                if (data_requested)
-                {
-                    stats.busTrafficBytes += blockSize;
-                    bus->addRemainingCycles(2 * (blockSize / 4), cacheId);
-                }
-            }
-            return true; // We have the data
+            line.state = CacheState::SHARED;
+            debugPrint("  Line transitioned to SHARED due to bus read transaction");
+        }
+        if (data_requested)
+        {
+            stats.busTrafficBytes += blockSize;
+            bus->charge(BusCycleSource::PeerCache, cacheId, blockSize / 4);
         }
     }
-    return false; // We don't have the data
+    return true; // We have the data
 }
 
-long long int Cache::read(uint32_t address, long long int coreId)
+CacheLine &Cache::fillLine(uint64_t address, bool isWrite, long long int coreId)
 {
-
-    if (bus->isBusyNow() && bus->getCurrentRequestingCore() == coreId)
-    {
-        std::stringstream ss;
-        ss.str("");
-        ss << "Bus is busy for core " << coreId;
-        debugPrint(ss.str());
-        return 2;
-    }
-
     uint32_t setIndex = getSetIndex(address);
-    uint32_t tag = getTag(address);
-
-    std::stringstream ss;
-    ss << "READ 0x" << std::hex << address << std::dec
-       << " (Set: " << setIndex << ", Tag: 0x" << std::hex << tag << std::dec << ")";
-    debugPrint(ss.str());
-
-    // Search for the line in the set
-    for (uint32_t i = 0; i < associativity; ++i)
-    {
-        CacheLine &line = sets[setIndex].lines[i];
-        if (line.tag == tag && line.state != CacheState::INVALID)
-        {
-            // Cache hit
-            stats.hitCount++;
-            updateLRU(setIndex, i);
-
-            ss.str("");
-            ss << "  HIT in way " << i << " (State: " << stateToString(line.state) << ")";
-            debugPrint(ss.str());
-            return 0;
-        }
-    }
-
-    if (bus->isBusyNow() && bus->getCurrentRequestingCore() != coreId)
-    {
-        std::stringstream ss;
-        ss << "Bus is busy for core " << bus->getCurrentRequestingCore();
-        debugPrint(ss.str());
-        return -1;
-    }
-
-    // Cache miss
-    stats.missCount++;
-    debugPrint("  READ MISS");
+    uint64_t tag = getTag(address);
 
     // Find a line to replace (LRU or INVALID)
     long long int replaceIdx = findLRULine(setIndex);
     CacheLine &victim = sets[setIndex].lines[replaceIdx];
 
-    ss.str("");
+    std::stringstream ss;
     ss << "  Replacing line in way " << replaceIdx;
     if (victim.state != CacheState::INVALID)
     {
@@ -242,166 +331,855 @@ long long int Cache::read(uint32_t address, long long int coreId)
     }
     debugPrint(ss.str());
 
-    // Write back if needed (if MODIFIED)
-    if (victim.state == CacheState::MODIFIED)
+    // Write back if needed (if MODIFIED). A line moved to the victim cache is
+    // written back when it leaves the victim cache.
+    bool toVictimCache = victimCacheSize > 0 && victim.state != CacheState::INVALID;
+    if (victim.state == CacheState::MODIFIED && !toVictimCache)
     {
-        writeBackToMemory(setIndex, replaceIdx);
+        writeBackToMemory(victim);
         debugPrint("  Writeback required - writing modified data to memory");
     }
+    uint64_t victimBlock = ((((static_cast<uint64_t>(tagRegions[victim.tagRegion]) << 32) | victim.tag)) << setIndexBits) | setIndex;
+    if (heatMap)
+    {
+        if (victim.state != CacheState::INVALID)
+        {
+            sets[setIndex].evictionCount++;
+            heatMap->record(HeatEvent::Eviction, victimBlock);
+        }
+        if (!prefetchInFlight)
+        {
+            sets[setIndex].missCount++;
+            heatMap->record(HeatEvent::Miss, address >> blockBits);
+        }
+    }
     if (victim.state != CacheState::INVALID)
     {
         stats.evictionCount++;
+        // A prefetched line moved to the victim cache keeps its mark: it is
+        // useful if a demand access swaps it back, unused if it leaves from there
+        if (victim.prefetched && !toVictimCache)
+        {
+            stats.prefetchUnused++;
+        }
+        if (victim.thread != activeThread && victim.thread < threadEvictions.size())
+        {
+            threadEvictions[victim.thread]++;
+        }
     }
-    //  Try to broadcast BusRd request on the bus
-    bool dataFromOtherCache = false;
-    if (bus)
+    if (toVictimCache)
     {
-        dataFromOtherCache = bus->broadcastTransaction(BusTransactionType::BusRd, address, coreId);
+        insertVictim(victimBlock, victim);
     }
+    victim.prefetched = false;
+    victim.thread = activeThread;
 
-    // If no other cache has the data or bus is busy, read from main memory
-    if (!dataFromOtherCache)
+    if (isWrite)
     {
-        // Set remaining cycles for memory access (100 cycles)
-        bus->addRemainingCycles(100, cacheId);
-        victim.state = CacheState::EXCLUSIVE; // We're the only one with this data
-        debugPrint("  Reading data from main memory - transitioning to EXCLUSIVE state");
+        bool dataFromOtherCache = false;
+        if (bus)
+        {
+            dataFromOtherCache = bus->broadcastTransaction(BusTransactionType::BusRdX, address, coreId);
+        }
+
+        if (dataFromOtherCache)
+        {
+            stats.invalidationCount++;
+        }
+        bus->charge(BusCycleSource::Memory, cacheId);
+        victim.state = CacheState::MODIFIED;
+        victim.dirty = true;
     }
     else
     {
-        victim.state = CacheState::SHARED; // Another cache had the data
-        debugPrint("  Received data from another cache - transitioning to SHARED state");
+        //  Try to broadcast BusRd request on the bus
+        bool dataFromOtherCache = false;
+        if (bus)
+        {
+            dataFromOtherCache = bus->broadcastTransaction(BusTransactionType::BusRd, address, coreId);
+        }
+
+        // If no other cache has the data or bus is busy, read from main memory
+        if (!dataFromOtherCache)
+        {
+            // Set remaining cycles for memory access (100 cycles)
+            bus->charge(BusCycleSource::Memory, cacheId);
+            victim.state = CacheState::EXCLUSIVE; // We're the only one with this data
+            debugPrint("  Reading data from main memory - transitioning to EXCLUSIVE state");
+        }
+        else
+        {
+            victim.state = CacheState::SHARED; // Another cache had the data
+            debugPrint("  Received data from another cache - transitioning to SHARED state");
+        }
+        victim.dirty = false;
     }
 
     stats.busTrafficBytes += blockSize;
     bus->stats.totalBusTraffic += blockSize;
     // Fill the line
-    victim.tag = tag;
-    victim.dirty = false;
+    setLineTag(victim, tag);
     updateLRU(setIndex, replaceIdx);
 
     debugPrint("  Line filled (State: " + stateToString(victim.state) + ")");
-    return 1;
+    return victim;
+}
+
+CacheLine *Cache::findLine(uint64_t address)
+{
+    uint32_t setIndex = getSetIndex(address);
+    uint64_t tag = getTag(address);
+    for (uint32_t i = 0; i < associativity; ++i)
+    {
+        CacheLine &line = sets[setIndex].lines[i];
+        if (tagMatches(line, tag) && line.state != CacheState::INVALID)
+        {
+            return &line;
+        }
+    }
+    for (size_t i = 0; i < victimCache.size(); ++i)
+    {
+        if (victimCache[i].blockAddress == (address >> blockBits) && victimCache[i].line.state != CacheState::INVALID)
+        {
+            return &victimCache[i].line;
+        }
+    }
+    return nullptr;
+}
+
+long long int Cache::lookupWay(uint32_t setIndex, uint64_t tag)
+{
+    CacheSet &set = sets[setIndex];
+    if (wayPrediction)
+    {
+        // Probe the predicted way alone first; the rest of the set is only
+        // read on a misprediction
+        const CacheLine &line = set.lines[set.predictedWay];
+        lookupPredicted = tagMatches(line, tag) && line.state != CacheState::INVALID;
+        lookupTagChecks = lookupPredicted ? 1 : associativity;
+        if (lookupPredicted)
+            return set.predictedWay;
+    }
+    for (uint32_t i = 0; i < associativity; ++i)
+    {
+        const CacheLine &line = set.lines[i];
+        if (tagMatches(line, tag) && line.state != CacheState::INVALID)
+        {
+            return i;
+        }
+    }
+    if (victimCacheSize > 0)
+    {
+        return swapFromVictimCache(setIndex, tag);
+    }
+    return -1;
 }
 
-long long int Cache::write(uint32_t address, long long int coreId)
-{ // 0:hit, 1:miss, -1:bus busy, 2:bus in progress
+void Cache::countLookup()
+{
+    if (!wayPrediction)
+        return;
+    stats.wayPredLookups++;
+    stats.tagChecks += lookupTagChecks;
+    if (lookupPredicted)
+    {
+        stats.wayPredHits++;
+    }
+}
 
-    if (bus->isBusyNow() && bus->getCurrentRequestingCore() == coreId)
+long long int Cache::swapFromVictimCache(uint32_t setIndex, uint64_t tag)
+{
+    uint64_t blockAddress = (tag << setIndexBits) | setIndex;
+    for (size_t i = 0; i < victimCache.size(); ++i)
     {
+        VictimEntry &entry = victimCache[i];
+        if (entry.blockAddress != blockAddress || entry.line.state == CacheState::INVALID)
+            continue;
+
+        // The set's LRU line takes the freed victim cache slot
+        long long int way = findLRULine(setIndex);
+        CacheLine &slot = sets[setIndex].lines[way];
+        CacheLine displaced = slot;
+        slot = entry.line;
+        entry.line = displaced;
+        entry.blockAddress = ((((static_cast<uint64_t>(tagRegions[displaced.tagRegion]) << 32) | displaced.tag)) << setIndexBits) | setIndex;
+        stats.victimHits++;
+
         std::stringstream ss;
-        ss << "Bus is busy for core " << coreId;
+        ss << "  Victim cache hit, swapped into way " << way;
         debugPrint(ss.str());
-        return 2;
+        return way;
     }
+    return -1;
+}
 
-    uint32_t setIndex = getSetIndex(address);
-    uint32_t tag = getTag(address);
+void Cache::insertVictim(uint64_t blockAddress, const CacheLine &line)
+{
+    VictimEntry entry = {blockAddress, line};
+    if (victimCache.size() < victimCacheSize)
+    {
+        victimCache.push_back(entry);
+        return;
+    }
 
-    std::stringstream ss;
-    ss << "WRITE 0x" << std::hex << address << std::dec
-       << " (Set: " << setIndex << ", Tag: 0x" << std::hex << tag << std::dec << ")";
-    debugPrint(ss.str());
+    // Reuse an invalidated entry, otherwise push out the least recently used line
+    size_t slot = 0;
+    for (size_t i = 0; i < victimCache.size(); ++i)
+    {
+        if (victimCache[i].line.state == CacheState::INVALID)
+        {
+            slot = i;
+            break;
+        }
+        if (victimCache[i].line.lastAccessTime < victimCache[slot].line.lastAccessTime)
+        {
+            slot = i;
+        }
+    }
+    if (victimCache[slot].line.state != CacheState::INVALID)
+    {
+        stats.victimEvictions++;
+        if (victimCache[slot].line.prefetched)
+        {
+            stats.prefetchUnused++;
+        }
+        if (victimCache[slot].line.state == CacheState::MODIFIED)
+        {
+            writeBackToMemory(victimCache[slot].line);
+            debugPrint("  Victim cache writeback - writing modified data to memory");
+        }
+    }
+    victimCache[slot] = entry;
+}
 
-    // Search for the line in the set
-    for (uint32_t i = 0; i < associativity; ++i)
+void Cache::recordAccess(uint64_t address)
+{
+    sets[getSetIndex(address)].accessCount++;
+    heatMap->record(HeatEvent::Access, address >> blockBits);
+}
+
+CacheState Cache::getLineState(uint64_t address)
+{
+    CacheLine *line = findLine(address);
+    return line ? line->state : CacheState::INVALID;
+}
+
+void Cache::warmAccess(uint64_t address, CacheState state, uint64_t stamp)
+{
+    uint32_t setIndex = getSetIndex(address);
+    uint64_t tag = getTag(address);
+    long long int way = -1;
+    for (uint32_t i = 0; i < associativity && way < 0; ++i)
     {
-        CacheLine &line = sets[setIndex].lines[i];
-        if (line.tag == tag && line.state != CacheState::INVALID)
+        const CacheLine &line = sets[setIndex].lines[i];
+        if (tagMatches(line, tag) && line.state != CacheState::INVALID)
         {
+            way = i;
+        }
+    }
+    if (way < 0)
+    {
+        // Victims are dropped: dirty data only matters for timing
+        way = findLRULine(setIndex);
+        setLineTag(sets[setIndex].lines[way], tag);
+    }
+    CacheLine &line = sets[setIndex].lines[way];
+    line.state = state;
+    line.dirty = (state == CacheState::MODIFIED);
+    line.prefetched = false;
+    line.lastAccessTime = stamp;
+    line.thread = noThread;
+}
 
-            ss.str("");
-            ss << "  HIT in way " << i << " (State: " << stateToString(line.state);
+void Cache::warmSnoop(uint64_t address, bool isWrite)
+{
+    CacheLine *line = findLine(address);
+    if (!line)
+        return;
+    line->state = isWrite ? CacheState::INVALID : CacheState::SHARED;
+    line->dirty = false;
+}
 
-            // If not MODIFIED, need to upgrade (MESI)
-            if (line.state != CacheState::MODIFIED)
+void Cache::exportLines(std::vector<SnapshotLine> &lines) const
+{
+    for (uint32_t s = 0; s < numSets; ++s)
+    {
+        const std::vector<CacheLine> &ways = sets[s].lines;
+        for (uint32_t i = 0; i < associativity; ++i)
+        {
+            // Recency is kept as a rank so a snapshot does not depend on when it was taken
+            uint32_t age = 0;
+            for (uint32_t j = 0; j < associativity; ++j)
             {
-                if (bus->isBusyNow())
+                if (ways[j].state != CacheState::INVALID &&
+                    (ways[j].lastAccessTime < ways[i].lastAccessTime || (ways[j].lastAccessTime == ways[i].lastAccessTime && j < i)))
                 {
-                    debugPrint("  Bus is busy, skipping BusUpgr");
-                    return -1;
+                    age++;
                 }
-                debugPrint("  Sending BusUpgr message on bus");
-                if (line.state == CacheState::SHARED)
+            }
+            SnapshotLine line = {(tagRegions[ways[i].tagRegion] << 32) | ways[i].tag, static_cast<uint8_t>(ways[i].state),
+                                 static_cast<uint8_t>(ways[i].dirty ? 1 : 0), ways[i].state == CacheState::INVALID ? 0 : age};
+            lines.push_back(line);
+        }
+    }
+}
+
+void Cache::importLines(const SnapshotLine *lines)
+{
+    for (uint32_t s = 0; s < numSets; ++s)
+    {
+        uint32_t newest = 0;
+        for (uint32_t i = 0; i < associativity; ++i)
+        {
+            const SnapshotLine &saved = lines[static_cast<size_t>(s) * associativity + i];
+            CacheLine &line = sets[s].lines[i];
+            setLineTag(line, saved.tag);
+            line.state = static_cast<CacheState>(saved.state);
+            line.dirty = saved.dirty != 0;
+            line.prefetched = false;
+            line.lastAccessTime = saved.age;
+            line.thread = noThread;
+            if (saved.age >= sets[s].lines[newest].lastAccessTime)
+            {
+                newest = i;
+            }
+        }
+        sets[s].predictedWay = newest;
+    }
+    // Warm lines carry LRU ranks 0..E-1; timed accesses stamp above them
+    lruBase = associativity;
+}
+
+bool Cache::containsBlock(uint64_t blockAddress)
+{
+    return findLine(blockAddress << blockBits) != nullptr;
+}
+
+void Cache::trainPrefetcher(uint64_t address, bool isMiss, bool prefetchHit)
+{
+    if (!prefetcher)
+        return;
+
+    std::vector<uint64_t> candidates;
+    prefetcher->onAccess(address >> blockBits, isMiss, prefetchHit, candidates);
+    for (size_t i = 0; i < candidates.size(); ++i)
+    {
+        uint64_t block = candidates[i];
+        bool queued = false;
+        for (size_t j = 0; j < prefetchQueue.size() && !queued; ++j)
+        {
+            queued = (prefetchQueue[j] == block);
+        }
+        if (queued || (prefetchInFlight && prefetchBlock == block) || findMSHR(block) || containsBlock(block))
+            continue;
+
+        // Bounded queue: the oldest request is the least likely to still be timely
+        const size_t maxQueued = 16;
+        if (prefetchQueue.size() >= maxQueued)
+        {
+            prefetchQueue.erase(prefetchQueue.begin());
+        }
+        prefetchQueue.push_back(block);
+    }
+}
+
+bool Cache::waitForPrefetch(uint64_t blockAddress)
+{
+    if (!prefetchInFlight || blockAddress != prefetchBlock)
+        return false;
+    // Only the first demand access that waits makes the prefetch late
+    if (!prefetchLateCounted)
+    {
+        stats.prefetchLate++;
+        prefetchLateCounted = true;
+    }
+    return true;
+}
+
+bool Cache::consumePrefetch(CacheLine &line)
+{
+    if (!line.prefetched)
+        return false;
+    stats.prefetchUseful++;
+    line.prefetched = false;
+    return true;
+}
+
+void Cache::issuePrefetch()
+{
+    while (!prefetchQueue.empty())
+    {
+        uint64_t block = prefetchQueue.front();
+        prefetchQueue.erase(prefetchQueue.begin());
+        if (containsBlock(block) || findMSHR(block))
+            continue; // Demand got there first
+
+        std::stringstream ss;
+        ss << "  PREFETCH 0x" << std::hex << (block << blockBits) << std::dec;
+        debugPrint(ss.str());
+
+        stats.prefetchIssued++;
+        prefetchInFlight = true;
+        prefetchLateCounted = false;
+        prefetchBlock = block;
+        CacheLine &line = fillLine(block << blockBits, false, cacheId);
+        line.prefetched = true;
+        return;
+    }
+}
+
+MSHREntry *Cache::findMSHR(uint64_t blockAddress)
+{
+    for (size_t i = 0; i < mshrs.size(); ++i)
+    {
+        if (mshrs[i].blockAddress == blockAddress)
+        {
+            return &mshrs[i];
+        }
+    }
+    return nullptr;
+}
+
+void Cache::tick()
+{
+    if (mshrCount == 0 && !prefetcher && storeBufferDepth == 0)
+        return;
+
+    // The issued miss or prefetch (at most one per core) is done once the interconnect no longer serves us
+    bool ownTransaction = bus->isServing(cacheId);
+    if (!ownTransaction)
+    {
+        prefetchInFlight = false;
+        if (storeDrainInFlight)
+        {
+            for (size_t i = 0; i < storeBuffer.size(); ++i)
+            {
+                if (storeBuffer[i].draining)
                 {
-                    stats.invalidationCount++;
+                    storeBuffer.erase(storeBuffer.begin() + i);
+                    stats.sbDrained++;
+                    break;
                 }
-                bus->broadcastTransaction(BusTransactionType::BusUpgr, address, coreId);
-                ss << " -> " << stateToString(CacheState::MODIFIED) << ")";
-                line.state = CacheState::MODIFIED;
             }
-            else
+            storeDrainInFlight = false;
+        }
+        for (size_t i = 0; i < mshrs.size(); ++i)
+        {
+            if (mshrs[i].issued)
+            {
+                debugPrint("  MSHR fill complete");
+                mshrs.erase(mshrs.begin() + i);
+                break;
+            }
+        }
+    }
+
+    // Issue the oldest queued miss as soon as the bus is free
+    if (bus->canIssue(cacheId))
+    {
+        for (size_t i = 0; i < mshrs.size(); ++i)
+        {
+            if (!mshrs[i].issued)
             {
-                ss << ")";
+                mshrs[i].issued = true;
+                uint8_t demandThread = activeThread;
+                activeThread = mshrs[i].thread;
+                fillLine(mshrs[i].blockAddress << blockBits, mshrs[i].isWrite, cacheId);
+                activeThread = demandThread;
+                break;
             }
+        }
+    }
+
+    if (storeBufferDepth > 0)
+    {
+        drainStoreBuffer();
+    }
+
+    if (mshrCount == 0)
+        return;
+
+    long long int occupancy = static_cast<long long int>(mshrs.size());
+    stats.mshrOccupancySum += occupancy;
+    stats.mshrSampledCycles++;
+    if (occupancy > stats.mshrOccupancyPeak)
+    {
+        stats.mshrOccupancyPeak = occupancy;
+    }
+}
 
-            // Cache hit
-            stats.hitCount++;
-            updateLRU(setIndex, i);
+void Cache::tickPrefetcher()
+{
+    // Runs after the demand accesses of the cycle, so a prefetch only gets the
+    // bus when no demand miss (ours or another core's) took it this cycle
+    if (prefetcher && bus->canIssue(cacheId))
+    {
+        issuePrefetch();
+    }
+}
 
+long long int Cache::accessNonBlocking(uint64_t address, bool isWrite, long long int coreId)
+{
+    uint32_t setIndex = getSetIndex(address);
+    uint64_t tag = getTag(address);
+    uint64_t blockAddress = address >> blockBits;
+    bool ownTransaction = bus->isServing(coreId);
+
+    std::stringstream ss;
+    ss << (isWrite ? "WRITE 0x" : "READ 0x") << std::hex << address << std::dec
+       << " (Set: " << setIndex << ", Tag: 0x" << std::hex << tag << std::dec << ")";
+    debugPrint(ss.str());
+
+    // Secondary miss: merge with the outstanding miss to the same block
+    MSHREntry *pending = findMSHR(blockAddress);
+    if (pending)
+    {
+        if (isWrite && !pending->isWrite)
+        {
+            if (pending->issued)
+            {
+                // Needs ownership, which the in-flight BusRd will not give us
+                stats.mshrStallCycles++;
+                return ownTransaction ? 2 : -1;
+            }
+            pending->isWrite = true; // Not on the bus yet, ask for BusRdX instead
+        }
+        stats.missCount++;
+        stats.mshrMergedMisses++;
+        debugPrint("  Merged into outstanding MSHR");
+        trainPrefetcher(address, true, false);
+        return 3;
+    }
+
+    // The block is still on its way in as a prefetch
+    if (waitForPrefetch(blockAddress))
+    {
+        return 2;
+    }
+
+    // Hits proceed under outstanding misses
+    long long int way = lookupWay(setIndex, tag);
+    if (way >= 0)
+    {
+        CacheLine &line = sets[setIndex].lines[way];
+        if (isWrite && line.state != CacheState::MODIFIED)
+        {
+            if (!bus->canIssue(coreId))
+            {
+                debugPrint("  Bus is busy, skipping BusUpgr");
+                return ownTransaction ? 2 : -1;
+            }
+            debugPrint("  Sending BusUpgr message on bus");
+            if (line.state == CacheState::SHARED)
+            {
+                stats.invalidationCount++;
+            }
+            bus->broadcastTransaction(BusTransactionType::BusUpgr, address, coreId);
+            bus->charge(BusCycleSource::Upgrade, coreId);
+            line.state = CacheState::MODIFIED;
+        }
+        if (isWrite)
+        {
             line.dirty = true;
-            debugPrint(ss.str());
+        }
+        bool prefetchHit = consumePrefetch(line);
+        stats.hitCount++;
+        countLookup();
+        updateLRU(setIndex, way);
+        debugPrint("  HIT (" + stateToString(line.state) + ")");
+        trainPrefetcher(address, false, prefetchHit);
+        return 0;
+    }
+
+    // Primary miss: needs a free MSHR
+    if (mshrs.size() >= mshrCount)
+    {
+        stats.mshrStallCycles++;
+        debugPrint("  All MSHRs busy");
+        return ownTransaction ? 2 : -1;
+    }
+
+    stats.missCount++;
+    countLookup();
+    debugPrint(isWrite ? "  WRITE MISS (MSHR allocated)" : "  READ MISS (MSHR allocated)");
+    MSHREntry entry = {blockAddress, isWrite, false, globalCycle, activeThread};
+    mshrs.push_back(entry);
+    if (bus->canIssue(coreId))
+    {
+        mshrs.back().issued = true;
+        fillLine(address, isWrite, coreId);
+    }
+    trainPrefetcher(address, true, false);
+    return 3;
+}
+
+long long int Cache::read(uint64_t address, long long int coreId)
+{
+    // A blocking cache serves nothing while our demand miss is on the bus, not
+    // even a forward: the missing access (of any SMT thread) retires only when
+    // the miss completes
+    if (mshrCount == 0 && bus->isServing(coreId) && !backgroundInFlight())
+    {
+        std::stringstream ss;
+        ss << "Bus is busy for core " << coreId;
+        debugPrint(ss.str());
+        return 2;
+    }
+
+    // Store-to-load forwarding (tracked at block granularity). The load never
+    // reaches the cache, so it is counted as forwarded rather than as a hit and
+    // leaves LRU order, way prediction and the prefetcher untouched.
+    for (size_t i = 0; i < storeBuffer.size(); ++i)
+    {
+        if (storeBuffer[i].blockAddress == (address >> blockBits))
+        {
+            stats.sbForwarded++;
+            debugPrint("  Load forwarded from store buffer");
             return 0;
         }
     }
 
-    if (bus->isBusyNow() && bus->getCurrentRequestingCore() != coreId)
+    if (mshrCount > 0)
+    {
+        return accessNonBlocking(address, false, coreId);
+    }
+
+    uint32_t setIndex = getSetIndex(address);
+    uint64_t tag = getTag(address);
+
+    std::stringstream ss;
+    ss << "READ 0x" << std::hex << address << std::dec
+       << " (Set: " << setIndex << ", Tag: 0x" << std::hex << tag << std::dec << ")";
+    debugPrint(ss.str());
+
+    // The block is still on its way in as a prefetch
+    if (waitForPrefetch(address >> blockBits))
+    {
+        return 2;
+    }
+
+    // Search for the line in the set
+    long long int way = lookupWay(setIndex, tag);
+    if (way >= 0)
+    {
+        CacheLine &line = sets[setIndex].lines[way];
+        // Cache hit
+        stats.hitCount++;
+        countLookup();
+        updateLRU(setIndex, way);
+
+        ss.str("");
+        ss << "  HIT in way " << way << " (State: " << stateToString(line.state) << ")";
+        debugPrint(ss.str());
+        bool prefetchHit = consumePrefetch(line);
+        trainPrefetcher(address, false, prefetchHit);
+        return 0;
+    }
+
+    if (backgroundInFlight())
+    {
+        debugPrint("  Bus is busy with our prefetch or store drain");
+        return 2;
+    }
+
+    if (!bus->canIssue(coreId) && !bus->isServing(coreId))
     {
         std::stringstream ss;
-        ss << "Bus is busy for core " << bus->getCurrentRequestingCore();
+        ss << "Bus is busy with another core, core " << coreId << " waits";
         debugPrint(ss.str());
         return -1;
     }
 
     // Cache miss
     stats.missCount++;
-    debugPrint("  WRITE MISS");
+    countLookup();
+    debugPrint("  READ MISS");
+    fillLine(address, false, coreId);
+    trainPrefetcher(address, true, false);
+    return 1;
+}
 
-    // Find a line to replace (LRU or INVALID)
-    long long int replaceIdx = findLRULine(setIndex);
-    CacheLine &victim = sets[setIndex].lines[replaceIdx];
+long long int Cache::write(uint64_t address, long long int coreId)
+{ // 0:hit, 1:miss, -1:bus busy, 2:bus in progress, 3:accepted, completes in the background
+    if (storeBufferDepth > 0)
+    {
+        return bufferWrite(address, coreId);
+    }
+    if (mshrCount > 0)
+    {
+        return accessNonBlocking(address, true, coreId);
+    }
+    return performWrite(address, coreId);
+}
 
-    ss.str("");
-    ss << "  Replacing line in way " << replaceIdx;
-    if (victim.state != CacheState::INVALID)
+long long int Cache::bufferWrite(uint64_t address, long long int coreId)
+{
+    uint64_t blockAddress = address >> blockBits;
+
+    // Coalesce with a buffered store to the same block. Under TSO only the youngest
+    // entry may absorb it, otherwise the store would overtake older stores. The
+    // buffered store counts as a hit or miss when it drains; a coalesced store
+    // never reaches the cache and is only counted as coalesced.
+    size_t first = (storeBufferTSO && !storeBuffer.empty()) ? storeBuffer.size() - 1 : 0;
+    for (size_t i = first; i < storeBuffer.size(); ++i)
     {
-        ss << " (Old state: " << stateToString(victim.state) << ")";
+        if (storeBuffer[i].blockAddress == blockAddress && !storeBuffer[i].draining)
+        {
+            storeBuffer[i].address = address;
+            storeBuffer[i].thread = activeThread;
+            stats.sbCoalesced++;
+            debugPrint("  Store coalesced in store buffer");
+            return 3;
+        }
     }
-    debugPrint(ss.str());
 
-    // Write back if needed (if MODIFIED)
-    if (victim.state == CacheState::MODIFIED)
+    if (storeBuffer.size() >= storeBufferDepth)
     {
-        writeBackToMemory(setIndex, replaceIdx);
-        debugPrint("  Writeback required - writing modified data to memory");
+        stats.sbStallCycles++;
+        debugPrint("  Store buffer full");
+        return bus->isServing(coreId) ? 2 : -1;
     }
-    if (victim.state != CacheState::INVALID)
+
+    StoreBufferEntry entry = {blockAddress, address, false, activeThread};
+    storeBuffer.push_back(entry);
+    if (static_cast<long long int>(storeBuffer.size()) > stats.sbOccupancyPeak)
     {
-        stats.evictionCount++;
+        stats.sbOccupancyPeak = storeBuffer.size();
     }
-    // why eviction only for modified?
+    debugPrint("  Store retired into store buffer");
+    return 3;
+}
 
-    bool dataFromOtherCache = false;
-    if (bus)
+void Cache::drainStoreBuffer()
+{
+    if (storeBuffer.empty() || storeDrainInFlight)
+        return;
+
+    // TSO drains strictly in order. Otherwise a younger store that already owns
+    // its line may retire past a head that is waiting for the bus.
+    size_t pick = 0;
+    if (!storeBufferTSO && !bus->canIssue(cacheId))
     {
-        dataFromOtherCache = bus->broadcastTransaction(BusTransactionType::BusRdX, address, coreId);
+        for (size_t i = 0; i < storeBuffer.size(); ++i)
+        {
+            CacheLine *line = findLine(storeBuffer[i].address);
+            if (line && line->state == CacheState::MODIFIED)
+            {
+                pick = i;
+                break;
+            }
+        }
     }
 
-    if (dataFromOtherCache)
+    StoreBufferEntry &entry = storeBuffer[pick];
+    uint8_t demandThread = activeThread;
+    activeThread = entry.thread;
+    long long int result = (mshrCount > 0) ? accessNonBlocking(entry.address, true, cacheId)
+                                           : performWrite(entry.address, cacheId);
+    activeThread = demandThread;
+    switch (result)
     {
-        stats.invalidationCount++;
+    case 0: // Written into the cache
+    case 3: // Handed to an MSHR
+        storeBuffer.erase(storeBuffer.begin() + pick);
+        stats.sbDrained++;
+        break;
+    case 1: // Write miss on the bus, retired in tick() when it completes
+        entry.draining = true;
+        storeDrainInFlight = true;
+        break;
+    default: // Bus not available, retry next cycle
+        break;
     }
-    bus->addRemainingCycles(100, cacheId);
-    stats.busTrafficBytes += blockSize;
-    bus->stats.totalBusTraffic += blockSize;
+}
 
-    // Fill the line
-    victim.tag = tag;
-    victim.state = CacheState::MODIFIED;
-    victim.dirty = true;
-    updateLRU(setIndex, replaceIdx);
+long long int Cache::performWrite(uint64_t address, long long int coreId)
+{
+    if (bus->isServing(coreId) && !backgroundInFlight())
+    {
+        std::stringstream ss;
+        ss << "Bus is busy for core " << coreId;
+        debugPrint(ss.str());
+        return 2;
+    }
 
-    debugPrint("  Line filled (State: " + stateToString(victim.state) + ")");
+    uint32_t setIndex = getSetIndex(address);
+    uint64_t tag = getTag(address);
+
+    std::stringstream ss;
+    ss << "WRITE 0x" << std::hex << address << std::dec
+       << " (Set: " << setIndex << ", Tag: 0x" << std::hex << tag << std::dec << ")";
+    debugPrint(ss.str());
+
+    // The block is still on its way in as a prefetch
+    if (waitForPrefetch(address >> blockBits))
+    {
+        return 2;
+    }
+
+    // Search for the line in the set
+    long long int way = lookupWay(setIndex, tag);
+    if (way >= 0)
+    {
+        CacheLine &line = sets[setIndex].lines[way];
+        ss.str("");
+        ss << "  HIT in way " << way << " (State: " << stateToString(line.state);
+
+        // If not MODIFIED, need to upgrade (MESI)
+        if (line.state != CacheState::MODIFIED)
+        {
+            if (!bus->canIssue(coreId))
+            {
+                debugPrint("  Bus is busy, skipping BusUpgr");
+                return backgroundInFlight() ? 2 : -1;
+            }
+            debugPrint("  Sending BusUpgr message on bus");
+            if (line.state == CacheState::SHARED)
+            {
+                stats.invalidationCount++;
+            }
+            bus->broadcastTransaction(BusTransactionType::BusUpgr, address, coreId);
+            bus->charge(BusCycleSource::Upgrade, coreId);
+            ss << " -> " << stateToString(CacheState::MODIFIED) << ")";
+            line.state = CacheState::MODIFIED;
+        }
+        else
+        {
+            ss << ")";
+        }
+
+        // Cache hit
+        stats.hitCount++;
+        countLookup();
+        updateLRU(setIndex, way);
+
+        line.dirty = true;
+        debugPrint(ss.str());
+        bool prefetchHit = consumePrefetch(line);
+        trainPrefetcher(address, false, prefetchHit);
+        return 0;
+    }
+
+    if (backgroundInFlight())
+    {
+        debugPrint("  Bus is busy with our prefetch or store drain");
+        return 2;
+    }
+
+    if (!bus->canIssue(coreId) && !bus->isServing(coreId))
+    {
+        std::stringstream ss;
+        ss << "Bus is busy with another core, core " << coreId << " waits";
+        debugPrint(ss.str());
+        return -1;
+    }
+
+    // Cache miss
+    stats.missCount++;
+    countLookup();
+    debugPrint("  WRITE MISS");
+    fillLine(address, true, coreId);
+    trainPrefetcher(address, true, false);
     return 1;
 }
 
@@ -411,6 +1189,25 @@ const CacheStats &Cache::getStats() const
     return stats;
 }
 
+long long int Cache::countPrefetchedLines() const
+{
+    long long int count = 0;
+    for (uint32_t i = 0; i < numSets; ++i)
+    {
+        for (const CacheLine &line : sets[i].lines)
+        {
+            if (line.state != CacheState::INVALID && line.prefetched)
+                count++;
+        }
+    }
+    for (const VictimEntry &entry : victimCache)
+    {
+        if (entry.line.state != CacheState::INVALID && entry.line.prefetched)
+            count++;
+    }
+    return count;
+}
+
 void Cache::printStats() const
 {
     // Print statistics in a format similar to the sample output
@@ -8,8 +8,11 @@
 #include <iostream>
 #include <fstream>
 
-// Forward declaration of Bus class
-class Bus;
+// Forward declaration of the interconnect interface
+class Interconnect;
+class Prefetcher;
+class HeatMap;
+struct SnapshotLine;
 
 // Cache line states for MESI protocol
 enum class CacheState
@@ -41,18 +44,28 @@ inline std::string stateToString(CacheState state)
 // Cache line structure
 struct CacheLine
 {
-    uint32_t tag;
+    uint32_t tag;               // Low 32 bits of the tag
+    uint32_t tagRegion;         // Index of the upper tag bits in Cache::tagRegions
     CacheState state;
     bool dirty;                 // Added dirty bit
+    bool prefetched;            // Brought in by a prefetch and not yet used
+    uint8_t thread;             // Hardware thread whose access filled the line (SMT), noThread if unknown
     uint64_t lastAccessTime;    // For LRU replacement
     std::vector<uint32_t> data; // Actual data stored in the cache line
 };
 
+// Owner of lines that were not filled by a timed access (initial and warm-up lines)
+const uint8_t noThread = 0xff;
+
 // Cache set structure
 struct CacheSet
 {
     std::vector<CacheLine> lines;
-    long long int accessCount;
+    long long int accessCount; // Per-set counters, kept only when a heat map is attached
+    long long int missCount;
+    long long int evictionCount;
+    long long int invalidationCount;
+    uint32_t predictedWay;     // Most recently used way, probed first with way prediction
 };
 
 // Cache statistics
@@ -69,6 +82,52 @@ struct CacheStats
     long long int execCycles;
     long long int idleCycles;
     long long int totalCycles;
+    long long int mshrMergedMisses;    // Secondary misses merged into an outstanding MSHR
+    long long int mshrStallCycles;     // Cycles stalled because all MSHRs were busy or on a dependency
+    long long int mshrOccupancySum;    // Sum of occupied MSHRs over sampled cycles
+    long long int mshrOccupancyPeak;   // Maximum number of MSHRs in use at once
+    long long int mshrSampledCycles;   // Cycles over which occupancy was sampled
+    long long int prefetchIssued;        // Prefetches that went out on the bus
+    long long int prefetchUseful;        // Prefetched lines later hit by a demand access
+    long long int prefetchLate;          // Demand accesses that found their prefetch still in flight
+    long long int prefetchUnused;        // Prefetched lines evicted or invalidated before use
+    long long int prefetchInvalidations; // Unused prefetched lines invalidated by another core
+    long long int sbCoalesced;           // Stores merged into a buffered store to the same block
+    long long int sbForwarded;           // Loads satisfied from the store buffer
+    long long int sbStallCycles;         // Cycles a store waited because the store buffer was full
+    long long int sbDrained;             // Buffered stores written into the cache
+    long long int sbOccupancyPeak;       // Maximum number of buffered stores
+    long long int victimHits;            // Set misses found in the victim cache
+    long long int victimEvictions;       // Lines pushed out of the victim cache
+    long long int wayPredLookups;        // Demand lookups that probed the predicted way
+    long long int wayPredHits;           // Lookups that hit in the predicted way
+    long long int tagChecks;             // Tag comparisons done by predicted lookups
+};
+
+// Miss status holding register: one outstanding miss to a block
+struct MSHREntry
+{
+    uint64_t blockAddress; // Address with the block offset stripped
+    bool isWrite;          // Needs an exclusive copy (BusRdX)
+    bool issued;           // Bus transaction has been started
+    uint64_t allocCycle;   // Cycle the miss was allocated
+    uint8_t thread;        // Hardware thread that missed
+};
+
+// Store buffer entry: retired stores to one block waiting to be written into the cache
+struct StoreBufferEntry
+{
+    uint64_t blockAddress; // Address with the block offset stripped
+    uint64_t address;      // Address of the latest store to the block
+    bool draining;         // Its write miss/upgrade is on the bus
+    uint8_t thread;        // Hardware thread of the latest store to the block
+};
+
+// Victim cache entry: a whole line evicted from its set, MESI state included
+struct VictimEntry
+{
+    uint64_t blockAddress; // Address with the block offset stripped
+    CacheLine line;        // Tag fields are kept, so the line can go straight back into its set
 };
 
 class Cache
@@ -81,31 +140,110 @@ private:
     uint32_t blockBits;
     uint32_t tagBits;
     std::vector<CacheSet> sets;
+    std::vector<uint64_t> tagRegions;                       // Distinct upper 32 tag bits of the cached lines
+    std::unordered_map<uint64_t, uint32_t> tagRegionIndex;  // Upper tag bits -> index in tagRegions
+    std::vector<uint32_t> freeTagRegions;                   // Recycled indices, no valid line refers to them
+    size_t tagRegionLimit;                                  // Table size at which unused regions are recycled
 
     uint64_t &globalCycle;          // Reference to global cycle counter (non-const)
+    uint64_t lruBase;               // Added to the cycle in LRU stamps, so imported warm lines stay older
     bool debugMode;                 // Added to control debug output
-    Bus *bus;                       // Pointer to the bus
+    Interconnect *bus;              // Bus, ring or mesh
     long long int cacheId;          // Added to identify which cache instance this is
+    uint32_t mshrCount;             // Number of MSHRs (0 = blocking cache)
+    std::vector<MSHREntry> mshrs;   // Outstanding misses, oldest first
+    Prefetcher *prefetcher;         // Optional prefetcher (not owned)
+    std::vector<uint64_t> prefetchQueue; // Block addresses waiting for the bus, oldest first
+    bool prefetchInFlight;          // The bus is currently serving one of our prefetches
+    bool prefetchLateCounted;       // A demand access already waited on the in-flight prefetch
+    uint64_t prefetchBlock;         // Block address of the in-flight prefetch
+    uint32_t storeBufferDepth;      // Store buffer entries (0 = stores go straight to the cache)
+    bool storeBufferTSO;            // Drain and coalesce in program order (TSO)
+    std::vector<StoreBufferEntry> storeBuffer; // Oldest first
+    bool storeDrainInFlight;        // The bus is currently serving a store buffer drain
+    HeatMap *heatMap;               // Optional per-set counters and hot-block sketches (not owned)
+    uint32_t victimCacheSize;       // Victim cache entries (0 = none)
+    std::vector<VictimEntry> victimCache;
+    bool wayPrediction;             // Probe the MRU way of a set before the others
+    bool lookupPredicted;           // Last lookup hit the predicted way
+    uint32_t lookupTagChecks;       // Tag comparisons of the last lookup
+    uint8_t activeThread;           // Hardware thread of the current access; fills are charged to it
+    std::vector<long long int> threadEvictions; // Lines of each thread evicted by another thread's fill (SMT)
     static std::ofstream debugFile; // Static file stream for debug output
 
     // Helper functions
-    uint32_t getSetIndex(uint32_t address);
-    uint32_t getTag(uint32_t address);
-    uint32_t getBlockOffset(uint32_t address);
+    uint32_t getSetIndex(uint64_t address);
+    uint64_t getTag(uint64_t address);
+    uint32_t getBlockOffset(uint64_t address);
+    // Tags are stored as 32 low bits plus an index into tagRegions
+    bool tagMatches(const CacheLine &line, uint64_t tag) const
+    {
+        return line.tag == static_cast<uint32_t>(tag) && tagRegions[line.tagRegion] == (tag >> 32);
+    }
+    void setLineTag(CacheLine &line, uint64_t tag);
+    void recycleTagRegions();
     long long int findLRULine(long long int setIndex);
     void updateLRU(long long int setIndex, long long int lineIndex);
-    void writeBackToMemory(long long int setIndex, long long int lineIndex);
+    void writeBackToMemory(CacheLine &line);
     void debugPrint(const std::string &msg) const; // Added debug print helper
+    CacheLine &fillLine(uint64_t address, bool isWrite, long long int coreId);
+    CacheLine *findLine(uint64_t address);
+    long long int lookupWay(uint32_t setIndex, uint64_t tag); // Way holding the block, -1 on a miss
+    void countLookup(); // Way prediction stats, once per accepted access (blocked accesses retry the lookup)
+    long long int swapFromVictimCache(uint32_t setIndex, uint64_t tag);
+    void insertVictim(uint64_t blockAddress, const CacheLine &line);
+    bool containsBlock(uint64_t blockAddress);
+    bool backgroundInFlight() const { return prefetchInFlight || storeDrainInFlight; }
+    long long int performWrite(uint64_t address, long long int coreId);
+    long long int bufferWrite(uint64_t address, long long int coreId);
+    void drainStoreBuffer();
+    void trainPrefetcher(uint64_t address, bool isMiss, bool prefetchHit);
+    bool waitForPrefetch(uint64_t blockAddress); // Block still in flight as a prefetch: counts it late once
+    bool consumePrefetch(CacheLine &line);       // Demand hit on a prefetched line: counts it useful once
+    void issuePrefetch();
+    long long int accessNonBlocking(uint64_t address, bool isWrite, long long int coreId);
+    MSHREntry *findMSHR(uint64_t blockAddress);
 public:
     CacheStats stats;
     Cache(uint32_t setIndexBits, uint32_t associativity, uint32_t blockBits, long long int id, uint64_t &cycle);
     ~Cache(); // Add destructor to close debug file
     void setDebugMode(bool enable) { debugMode = enable; }
-    void setBus(Bus *busPtr) { bus = busPtr; }
-    long long int read(uint32_t address, long long int coreId);
-    long long int write(uint32_t address, long long int coreId);
-    bool processBusTransaction(uint32_t address, bool isWrite, long long int requestingCore, bool data_requested);
+    void setBus(Interconnect *busPtr) { bus = busPtr; }
+    void setMSHRCount(uint32_t count) { mshrCount = count; }
+    bool isNonBlocking() const { return mshrCount > 0; }
+    void setPrefetcher(Prefetcher *pf) { prefetcher = pf; }
+    // SMT: several hardware threads share this cache. Set the thread before each
+    // access; prefetches are charged to the thread that issued the last access.
+    void setThreads(uint32_t count) { threadEvictions.assign(count > 1 ? count : 0, 0); }
+    void setActiveThread(uint32_t thread) { activeThread = static_cast<uint8_t>(thread); }
+    long long int getInterThreadEvictions(uint32_t thread) const
+    {
+        return thread < threadEvictions.size() ? threadEvictions[thread] : 0;
+    }
+    void setStoreBuffer(uint32_t depth, bool tso) { storeBufferDepth = depth; storeBufferTSO = tso; }
+    void setHeatMap(HeatMap *map) { heatMap = map; }
+    void setVictimCache(uint32_t entries) { victimCacheSize = entries; victimCache.reserve(entries); }
+    void setWayPrediction(bool enable) { wayPrediction = enable; }
+    void recordAccess(uint64_t address); // Demand access accepted, for the heat map
+    uint32_t getNumSets() const { return numSets; }
+    const CacheSet &getSet(uint32_t setIndex) const { return sets[setIndex]; }
+    bool hasPendingWork() const { return !mshrs.empty() || !storeBuffer.empty(); }
+    bool hasBackgroundTransaction() const { return backgroundInFlight(); } // Bus serves a prefetch or store drain
+    void tick(); // Per-cycle background work (MSHR retire/issue, store buffer drain)
+    void tickPrefetcher(); // Issues a queued prefetch; called after every core's demand access of the cycle
+    long long int read(uint64_t address, long long int coreId);
+    long long int write(uint64_t address, long long int coreId); // 0:hit, 1:miss, -1:bus busy, 2:bus in progress, 3:accepted, completes in the background
+    bool processBusTransaction(uint64_t address, bool isWrite, long long int requestingCore, bool data_requested);
+    CacheState getLineState(uint64_t address); // INVALID if the block is not cached (directory lookups)
+
+    // Functional warm-up: no timing, statistics or bus traffic. The caller keeps
+    // the caches coherent by snooping the other caches itself.
+    void warmAccess(uint64_t address, CacheState state, uint64_t stamp); // Hit or silent fill, ends in `state`
+    void warmSnoop(uint64_t address, bool isWrite);                      // Invalidate or downgrade to SHARED
+    void exportLines(std::vector<SnapshotLine> &lines) const;            // Appends every set, way by way
+    void importLines(const SnapshotLine *lines);                         // Inverse of exportLines
     const CacheStats &getStats() const;
+    long long int countPrefetchedLines() const; // Prefetched lines not used yet, in the sets and the victim cache
     void resetStats();
     void printStats() const;
 
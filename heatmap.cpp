@@ -0,0 +1,89 @@
+#include "heatmap.h"
+#include <algorithm>
+
+const char *heatEventName(HeatEvent event)
+{
+    switch (event)
+    {
+    case HeatEvent::Access:
+        return "Accesses";
+    case HeatEvent::Miss:
+        return "Misses";
+    case HeatEvent::Eviction:
+        return "Evictions";
+    case HeatEvent::Invalidation:
+        return "Invalidations";
+    }
+    return "Unknown";
+}
+
+TopKSketch::TopKSketch(size_t capacity) : capacity(capacity == 0 ? 1 : capacity), entries(), index()
+{
+    entries.reserve(this->capacity);
+}
+
+void TopKSketch::add(uint64_t key, uint64_t weight)
+{
+    std::unordered_map<uint64_t, size_t>::iterator it = index.find(key);
+    if (it != index.end())
+    {
+        entries[it->second].count += weight;
+        return;
+    }
+    if (entries.size() < capacity)
+    {
+        Entry entry = {key, weight, 0};
+        index[key] = entries.size();
+        entries.push_back(entry);
+        return;
+    }
+
+    // Full: the new key takes over the smallest counter
+    size_t victim = 0;
+    for (size_t i = 1; i < entries.size(); ++i)
+    {
+        if (entries[i].count < entries[victim].count)
+        {
+            victim = i;
+        }
+    }
+    index.erase(entries[victim].key);
+    index[key] = victim;
+    entries[victim].key = key;
+    entries[victim].error = entries[victim].count;
+    entries[victim].count += weight;
+}
+
+std::vector<TopKSketch::Entry> TopKSketch::top(size_t n) const
+{
+    std::vector<Entry> sorted(entries);
+    std::sort(sorted.begin(), sorted.end(), [](const Entry &a, const Entry &b)
+              { return a.count != b.count ? a.count > b.count : a.key < b.key; });
+    if (sorted.size() > n)
+    {
+        sorted.resize(n);
+    }
+    return sorted;
+}
+
+HeatMap::HeatMap(uint32_t sampleRate, size_t sketchCapacity)
+    : sampleRate(sampleRate == 0 ? 1 : sampleRate), rngState(0x9e3779b97f4a7c15ULL), sketches(heatEventCount, TopKSketch(sketchCapacity))
+{
+    for (int e = 0; e < heatEventCount; ++e)
+    {
+        untilSample[e] = nextSkip();
+        sampled[e] = 0;
+    }
+}
+
+uint64_t HeatMap::nextSkip()
+{
+    if (sampleRate == 1)
+        return 1;
+    // Uniform in [1, 2 * rate - 1]: one sample per `rate` events on average
+    // without locking onto periodic access patterns
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 7;
+    rngState ^= rngState << 17;
+    return 1 + rngState % (2 * static_cast<uint64_t>(sampleRate) - 1);
+}
@@ -0,0 +1,78 @@
+#ifndef HEATMAP_H
+#define HEATMAP_H
+
+#include <vector>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+// Events tracked per block address
+enum class HeatEvent
+{
+    Access,       // Demand access accepted by the cache
+    Miss,         // Demand miss that went to the bus
+    Eviction,     // Valid line replaced
+    Invalidation, // Copy invalidated by another core's write
+};
+
+const int heatEventCount = 4;
+const char *heatEventName(HeatEvent event);
+
+// Space-Saving top-K sketch: keeps at most `capacity` keys. A new key that
+// finds the sketch full replaces the smallest counter and inherits its count
+// as error, so every key whose true count exceeds total / capacity is kept
+// and no count is underestimated by more than `error`.
+class TopKSketch
+{
+public:
+    struct Entry
+    {
+        uint64_t key;
+        uint64_t count; // Upper bound of the true count
+        uint64_t error; // count - error is a lower bound
+    };
+
+private:
+    size_t capacity;
+    std::vector<Entry> entries;
+    std::unordered_map<uint64_t, size_t> index; // key -> position in entries
+
+public:
+    explicit TopKSketch(size_t capacity);
+    void add(uint64_t key, uint64_t weight);
+    std::vector<Entry> top(size_t n) const; // Largest counts first
+};
+
+// Hot block tracking shared by all caches. Only a sample of the events feeds
+// the sketches (on average one in `sampleRate`, weighted by the rate), so the
+// cost per event is a counter decrement; the per-set counters in CacheSet are
+// exact.
+class HeatMap
+{
+private:
+    uint32_t sampleRate;
+    uint64_t rngState;                  // xorshift64, fixed seed so runs are reproducible
+    uint64_t untilSample[heatEventCount]; // Events left to skip before the next sample
+    std::vector<TopKSketch> sketches;   // One per event type
+    uint64_t sampled[heatEventCount];
+
+    uint64_t nextSkip();
+
+public:
+    HeatMap(uint32_t sampleRate, size_t sketchCapacity);
+    void record(HeatEvent event, uint64_t blockAddress)
+    {
+        int e = static_cast<int>(event);
+        if (--untilSample[e] == 0)
+        {
+            untilSample[e] = nextSkip();
+            sketches[e].add(blockAddress, sampleRate);
+            sampled[e]++;
+        }
+    }
+    uint32_t getSampleRate() const { return sampleRate; }
+    uint64_t getSampled(HeatEvent event) const { return sampled[static_cast<int>(event)]; }
+    std::vector<TopKSketch::Entry> hottest(HeatEvent event, size_t n) const { return sketches[static_cast<int>(event)].top(n); }
+};
+
+#endif // HEATMAP_H
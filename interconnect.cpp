@@ -0,0 +1,53 @@
+#include "interconnect.h"
+#include <iomanip>
+
+const char *busCycleSourceName(BusCycleSource source)
+{
+    switch (source)
+    {
+    case BusCycleSource::Memory:
+        return "Memory";
+    case BusCycleSource::PeerCache:
+        return "Peer Cache";
+    case BusCycleSource::Writeback:
+        return "Writeback";
+    case BusCycleSource::Upgrade:
+        return "Upgrade";
+    }
+    return "Unknown";
+}
+
+void Interconnect::charge(BusCycleSource source, long long int coreId, uint32_t blockWords)
+{
+    const long long int cost[busCycleSourceCount] = {
+        latencies.memory,                                                  // Memory
+        static_cast<long long int>(latencies.transferPerWord) * blockWords, // PeerCache
+        latencies.writeback,                                               // Writeback
+        latencies.upgrade,                                                 // Upgrade
+    };
+    size_t s = static_cast<size_t>(source);
+    if (s >= static_cast<size_t>(busCycleSourceCount))
+        return;
+    if (cost[s] > 0 && !addRemainingCycles(cost[s], coreId))
+        return;
+    stats.sourceCycles[s] += cost[s];
+    stats.sourceCharges[s]++;
+}
+
+void Interconnect::printCostBreakdown(std::ostream &out) const
+{
+    uint64_t total = 0;
+    for (int s = 0; s < busCycleSourceCount; ++s)
+    {
+        total += stats.sourceCycles[s];
+    }
+    out << "Latency Model: memory " << latencies.memory << ", writeback " << latencies.writeback
+        << ", cache-to-cache " << latencies.transferPerWord << " per word, upgrade " << latencies.upgrade << " cycles\n";
+    out << "Charged Cycles by Source:\n";
+    for (int s = 0; s < busCycleSourceCount; ++s)
+    {
+        out << "  " << busCycleSourceName(static_cast<BusCycleSource>(s)) << ": " << stats.sourceCycles[s]
+            << " cycles in " << stats.sourceCharges[s] << " charges (" << std::fixed << std::setprecision(2)
+            << (total > 0 ? 100.0 * stats.sourceCycles[s] / total : 0.0) << "%)\n";
+    }
+}
@@ -0,0 +1,114 @@
+#ifndef INTERCONNECT_H
+#define INTERCONNECT_H
+
+#include <cstdint>
+#include <string>
+#include <iostream>
+
+class Cache;
+
+// Bus transaction types for MESI protocol
+enum class BusTransactionType
+{
+    BusRd,   // Bus Read - Request for shared copy
+    BusRdX,  // Bus Read Exclusive - Request for exclusive copy
+    BusUpgr, // Bus Upgrade - Request to upgrade to exclusive
+};
+
+// Bus transaction structure
+struct BusTransaction
+{
+    BusTransactionType type;
+    uint64_t address;
+    long long int requestingCore;
+    uint64_t timestamp;
+};
+
+const int busTransactionTypeCount = 3;
+
+// Components of a transaction's interconnect time, see Interconnect::charge
+enum class BusCycleSource
+{
+    Memory,    // Block read from memory
+    PeerCache, // Block supplied by another cache
+    Writeback, // Dirty block written back to memory
+    Upgrade,   // BusUpgr invalidation
+};
+
+const int busCycleSourceCount = 4;
+const char *busCycleSourceName(BusCycleSource source);
+
+// Cycles charged per component (the defaults are the original fixed costs)
+struct BusLatencies
+{
+    uint32_t memory;          // Also charged to every BusRdX, as before
+    uint32_t writeback;
+    uint32_t transferPerWord; // Cache-to-cache transfer, per 4-byte word
+    uint32_t upgrade;
+
+    BusLatencies() : memory(100), writeback(100), transferPerWord(2), upgrade(0) {}
+};
+
+// Bus statistics
+struct BusStats
+{
+    uint64_t totalTransactions;
+    uint64_t busRdTransactions;
+    uint64_t busRdXTransactions;
+    uint64_t busUpgrTransactions;
+    uint64_t totalBusTraffic;
+    uint64_t sourceCycles[busCycleSourceCount];  // Cycles charged per component
+    uint64_t sourceCharges[busCycleSourceCount]; // Number of charges per component
+    uint64_t elapsedCycles;                      // Cycles simulated
+    uint64_t busyCycles;                         // Cycles the bus was held (snooping bus only)
+    uint64_t typeBusyCycles[busTransactionTypeCount];
+};
+
+// What a cache sees of the interconnect. The snooping Bus serves one
+// transaction at a time for the whole system; the ring and mesh give every
+// core its own outstanding transaction and charge latency per link instead.
+class Interconnect
+{
+public:
+    BusStats stats;
+
+protected:
+    BusLatencies latencies;
+
+public:
+    Interconnect() : stats(), latencies() {}
+    virtual ~Interconnect() {}
+
+    virtual void setDebugMode(bool enable) = 0;
+    virtual void registerCache(Cache &cache) = 0;
+
+    // Runs the coherence actions of a miss or upgrade and starts its timing.
+    // Returns true if another cache held the block.
+    virtual bool broadcastTransaction(BusTransactionType type, uint64_t address, long long int requestingCore) = 0;
+    // Returns false if the cycles are not charged (covered by another cost)
+    virtual bool addRemainingCycles(long long int cycles, long long int coreId) = 0;
+    virtual void updateBusState() = 0; // Called once at the start of every cycle
+
+    virtual bool isServing(long long int core) const = 0;  // A transaction of this core is in flight
+    virtual bool canIssue(long long int core) const = 0;   // This core may start a transaction now
+    virtual bool missCompleting(long long int core) const = 0; // The core's miss finishes this cycle
+
+    // Occupy the interconnect for one component of the current transaction.
+    // blockWords is only used for cache-to-cache transfers.
+    void charge(BusCycleSource source, long long int coreId, uint32_t blockWords = 0);
+    void setLatencies(const BusLatencies &lat) { latencies = lat; }
+    const BusLatencies &getLatencies() const { return latencies; }
+
+    virtual std::string describe() const = 0;
+    virtual void printStats(std::ostream &out = std::cout) const = 0;
+    virtual void printCostBreakdown(std::ostream &out) const; // Cycles charged per component
+    const BusStats &getStats() const { return stats; }
+    void resetStats() { stats = BusStats{}; }
+};
+
+bool isKnownInterconnect(const std::string &type);
+// nullptr for an unknown type. meshCols = 0 picks a near-square mesh.
+Interconnect *createInterconnect(const std::string &type, long long int numCores, uint32_t blockBits, uint64_t &cycle,
+                                 uint32_t meshCols, uint32_t hopLatency, uint32_t flitBytes);
+
+#endif // INTERCONNECT_H
@@ -0,0 +1,232 @@
+#include "l1sim.h"
+#include "simulator.h"
+#include "shmring.h"
+#include <sched.h>
+
+struct l1sim_ring
+{
+    ShmRing *ring;
+};
+
+struct l1sim
+{
+    Simulator sim;
+    explicit l1sim(const SimulationParams &params) : sim(params) {}
+};
+
+static bool validCore(const l1sim *sim, int core)
+{
+    return sim && core >= 0 && core < sim->sim.getNumCores();
+}
+
+void l1sim_default_config(l1sim_config *config)
+{
+    SimulationParams defaults;
+    config->set_index_bits = static_cast<int>(defaults.setIndexBits);
+    config->associativity = static_cast<int>(defaults.associativity);
+    config->block_bits = static_cast<int>(defaults.blockBits);
+    config->num_cores = static_cast<int>(defaults.numCores);
+    config->mshrs = static_cast<int>(defaults.mshrs);
+    config->prefetcher = "none";
+    config->prefetch_degree = static_cast<int>(defaults.prefetchDegree);
+    config->prefetch_distance = static_cast<int>(defaults.prefetchDistance);
+    config->store_buffer_depth = static_cast<int>(defaults.storeBufferDepth);
+    config->store_buffer_tso = defaults.storeBufferTSO ? 1 : 0;
+    config->victim_entries = static_cast<int>(defaults.victimEntries);
+    config->way_prediction = defaults.wayPrediction ? 1 : 0;
+    config->interconnect = "bus";
+    config->mesh_cols = static_cast<int>(defaults.meshCols);
+    config->hop_latency = static_cast<int>(defaults.hopLatency);
+    config->flit_bytes = static_cast<int>(defaults.flitBytes);
+    config->mem_latency = static_cast<int>(defaults.busLatencies.memory);
+    config->writeback_latency = static_cast<int>(defaults.busLatencies.writeback);
+    config->c2c_word_latency = static_cast<int>(defaults.busLatencies.transferPerWord);
+    config->upgrade_latency = static_cast<int>(defaults.busLatencies.upgrade);
+}
+
+l1sim *l1sim_create(const l1sim_config *config)
+{
+    if (!config || config->num_cores <= 0 || config->associativity <= 0 ||
+        config->set_index_bits < 0 || config->block_bits < 0)
+    {
+        return nullptr;
+    }
+
+    SimulationParams params;
+    params.setIndexBits = config->set_index_bits;
+    params.associativity = config->associativity;
+    params.blockBits = config->block_bits;
+    params.numCores = config->num_cores;
+    params.mshrs = config->mshrs;
+    params.prefetcher = config->prefetcher ? config->prefetcher : "none";
+    params.prefetchDegree = config->prefetch_degree;
+    params.prefetchDistance = config->prefetch_distance;
+    params.storeBufferDepth = config->store_buffer_depth;
+    params.storeBufferTSO = config->store_buffer_tso != 0;
+    params.victimEntries = config->victim_entries;
+    params.wayPrediction = config->way_prediction != 0;
+    params.interconnect = config->interconnect ? config->interconnect : "bus";
+    params.meshCols = config->mesh_cols;
+    params.hopLatency = config->hop_latency;
+    params.flitBytes = config->flit_bytes;
+    if (config->mem_latency < 0 || config->writeback_latency < 0 || config->c2c_word_latency < 0 || config->upgrade_latency < 0)
+    {
+        return nullptr;
+    }
+    params.busLatencies.memory = static_cast<uint32_t>(config->mem_latency);
+    params.busLatencies.writeback = static_cast<uint32_t>(config->writeback_latency);
+    params.busLatencies.transferPerWord = static_cast<uint32_t>(config->c2c_word_latency);
+    params.busLatencies.upgrade = static_cast<uint32_t>(config->upgrade_latency);
+    if (params.prefetcher != "none" && !isKnownPrefetcher(params.prefetcher))
+    {
+        return nullptr;
+    }
+    if (params.prefetchDegree < 1 || params.prefetchDegree > maxPrefetchDegree || params.prefetchDistance < 1 ||
+        params.prefetchDistance > maxPrefetchDegree)
+    {
+        return nullptr;
+    }
+    if (params.mshrs < 0 || params.storeBufferDepth < 0 || params.victimEntries < 0)
+    {
+        return nullptr;
+    }
+    if (!isKnownInterconnect(params.interconnect) || params.meshCols < 0 || params.hopLatency <= 0 || params.flitBytes <= 0)
+    {
+        return nullptr;
+    }
+    return new l1sim(params);
+}
+
+void l1sim_destroy(l1sim *sim)
+{
+    delete sim;
+}
+
+int l1sim_load_traces(l1sim *sim, const char *base_trace_name)
+{
+    if (!sim || !base_trace_name)
+        return -1;
+    return sim->sim.loadTraces(base_trace_name) ? 0 : -1;
+}
+
+int l1sim_push(l1sim *sim, int core, int is_write, uint64_t address)
+{
+    if (!validCore(sim, core))
+        return -1;
+    sim->sim.pushAccess(core, is_write != 0, address);
+    return 0;
+}
+
+int l1sim_push_batch(l1sim *sim, int core, const l1sim_access *accesses, size_t count)
+{
+    if (!validCore(sim, core))
+        return -1;
+    for (size_t i = 0; i < count; ++i)
+    {
+        sim->sim.pushAccess(core, accesses[i].is_write != 0, accesses[i].address);
+    }
+    return 0;
+}
+
+int l1sim_step(l1sim *sim, uint64_t cycles)
+{
+    if (!sim)
+        return -1;
+    return sim->sim.step(cycles) ? 1 : 0;
+}
+
+int l1sim_run(l1sim *sim)
+{
+    if (!sim)
+        return -1;
+    sim->sim.run();
+    return 1;
+}
+
+int l1sim_done(const l1sim *sim)
+{
+    if (!sim)
+        return -1;
+    return sim->sim.isDone() ? 1 : 0;
+}
+
+uint64_t l1sim_cycle(const l1sim *sim)
+{
+    return sim ? sim->sim.getCycle() : 0;
+}
+
+size_t l1sim_pending(const l1sim *sim, int core)
+{
+    return validCore(sim, core) ? sim->sim.getPendingAccesses(core) : 0;
+}
+
+int l1sim_get_core_stats(const l1sim *sim, int core, l1sim_core_stats *stats)
+{
+    if (!validCore(sim, core) || !stats)
+        return -1;
+    const CacheStats &cs = sim->sim.getCacheStats(core);
+    stats->instructions = sim->sim.getInstructions(core);
+    stats->reads = cs.readCount;
+    stats->writes = cs.writeCount;
+    stats->hits = cs.hitCount;
+    stats->misses = cs.missCount;
+    stats->evictions = cs.evictionCount;
+    stats->writebacks = cs.writebackCount;
+    stats->invalidations = cs.invalidationCount;
+    stats->traffic_bytes = cs.busTrafficBytes;
+    stats->exec_cycles = cs.execCycles;
+    stats->idle_cycles = cs.idleCycles;
+    return 0;
+}
+
+void l1sim_get_bus_stats(const l1sim *sim, l1sim_bus_stats *stats)
+{
+    if (!sim || !stats)
+        return;
+    const BusStats &bs = sim->sim.getBusStats();
+    stats->transactions = bs.totalTransactions;
+    stats->bus_rd = bs.busRdTransactions;
+    stats->bus_rdx = bs.busRdXTransactions;
+    stats->bus_upgr = bs.busUpgrTransactions;
+    stats->traffic_bytes = bs.totalBusTraffic;
+    stats->busy_cycles = bs.busyCycles;
+    stats->elapsed_cycles = bs.elapsedCycles;
+}
+
+l1sim_ring *l1sim_ring_attach(const char *name, int core)
+{
+    if (!name || core < 0)
+        return nullptr;
+    ShmRing *ring = ShmRing::attach(ShmRing::coreRingName(name, core));
+    if (!ring)
+        return nullptr;
+    l1sim_ring *handle = new l1sim_ring;
+    handle->ring = ring;
+    return handle;
+}
+
+int l1sim_ring_try_push(l1sim_ring *ring, int is_write, uint64_t address)
+{
+    if (!ring)
+        return -1;
+    return ring->ring->push(is_write != 0, address) ? 0 : -1;
+}
+
+void l1sim_ring_push(l1sim_ring *ring, int is_write, uint64_t address)
+{
+    if (!ring)
+        return;
+    while (!ring->ring->push(is_write != 0, address))
+    {
+        sched_yield(); // The simulator is behind, let it drain
+    }
+}
+
+void l1sim_ring_close(l1sim_ring *ring)
+{
+    if (!ring)
+        return;
+    ring->ring->close();
+    delete ring->ring;
+    delete ring;
+}
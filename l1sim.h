@@ -0,0 +1,117 @@
+#ifndef L1SIM_H
+#define L1SIM_H
+
+/* C interface to the L1 cache coherence simulator (libl1sim).
+ *
+ *   l1sim_config cfg;
+ *   l1sim_default_config(&cfg);
+ *   l1sim *sim = l1sim_create(&cfg);
+ *   l1sim_push(sim, core, is_write, address);   // feed accesses as the CPU model produces them
+ *   l1sim_step(sim, n);                         // advance n cycles
+ *   l1sim_get_core_stats(sim, core, &stats);
+ *   l1sim_destroy(sim);
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+typedef struct l1sim l1sim;
+
+typedef struct l1sim_config
+{
+    int set_index_bits;
+    int associativity;
+    int block_bits;
+    int num_cores;
+    int mshrs;               /* 0 = blocking caches */
+    const char *prefetcher;  /* "none", "nextline", "stride", "stream" */
+    int prefetch_degree;     /* 1 to 64 */
+    int prefetch_distance;   /* 1 to 64 */
+    int store_buffer_depth;  /* 0 = no store buffer */
+    int store_buffer_tso;
+    int victim_entries;       /* 0 = no victim cache */
+    int way_prediction;
+    const char *interconnect; /* "bus", "ring", "mesh" */
+    int mesh_cols;            /* 0 = near-square */
+    int hop_latency;
+    int flit_bytes;
+    int mem_latency;          /* cycles to read a block from memory */
+    int writeback_latency;
+    int c2c_word_latency;     /* cache-to-cache cycles per 4-byte word */
+    int upgrade_latency;
+} l1sim_config;
+
+typedef struct l1sim_access
+{
+    int is_write;
+    uint64_t address;
+} l1sim_access;
+
+typedef struct l1sim_core_stats
+{
+    uint64_t instructions;
+    uint64_t reads;
+    uint64_t writes;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    uint64_t writebacks;
+    uint64_t invalidations;
+    uint64_t traffic_bytes;
+    uint64_t exec_cycles;
+    uint64_t idle_cycles;
+} l1sim_core_stats;
+
+typedef struct l1sim_bus_stats
+{
+    uint64_t transactions;
+    uint64_t bus_rd;
+    uint64_t bus_rdx;
+    uint64_t bus_upgr;
+    uint64_t traffic_bytes;
+    uint64_t busy_cycles;    /* cycles the snooping bus was held */
+    uint64_t elapsed_cycles;
+} l1sim_bus_stats;
+
+void l1sim_default_config(l1sim_config *config);
+l1sim *l1sim_create(const l1sim_config *config); /* NULL on invalid configuration */
+void l1sim_destroy(l1sim *sim);
+
+/* Input. Return 0 on success, -1 on a NULL simulator or a bad core index. */
+int l1sim_load_traces(l1sim *sim, const char *base_trace_name);
+int l1sim_push(l1sim *sim, int core, int is_write, uint64_t address);
+int l1sim_push_batch(l1sim *sim, int core, const l1sim_access *accesses, size_t count);
+
+/* Execution. step/run return 1 once every queued access has completed; step,
+ * run and done return -1 on a NULL simulator. */
+int l1sim_step(l1sim *sim, uint64_t cycles);
+int l1sim_run(l1sim *sim);
+int l1sim_done(const l1sim *sim);
+
+/* Statistics. A NULL simulator has cycle 0 and no pending accesses; the stats
+ * calls leave *stats untouched for a NULL simulator or a bad core index. */
+uint64_t l1sim_cycle(const l1sim *sim);
+size_t l1sim_pending(const l1sim *sim, int core);
+int l1sim_get_core_stats(const l1sim *sim, int core, l1sim_core_stats *stats);
+void l1sim_get_bus_stats(const l1sim *sim, l1sim_bus_stats *stats);
+
+/* Producer side of the live-capture rings (see L1simulate --shm). An
+ * instrumentation stub attaches to the ring of the core it feeds, pushes one
+ * record per memory reference and closes the ring when the thread exits. */
+typedef struct l1sim_ring l1sim_ring;
+
+l1sim_ring *l1sim_ring_attach(const char *name, int core); /* NULL until the simulator has created the ring */
+int l1sim_ring_try_push(l1sim_ring *ring, int is_write, uint64_t address); /* 0, or -1 if the ring is full or NULL */
+void l1sim_ring_push(l1sim_ring *ring, int is_write, uint64_t address);    /* Waits while the ring is full, no-op on NULL */
+void l1sim_ring_close(l1sim_ring *ring);                                   /* End of stream, detaches */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* L1SIM_H */
@@ -1,12 +1,12 @@
 #include <iostream>
 #include <fstream>
 #include <string>
-#include <vector>
 #include <cstring>
 #include <cstdlib>
-#include <iomanip>
-#include "cache.h"
-#include "bus.h"
+#include <memory>
+#include "simulator.h"
+#include "shmring.h"
+#include "profiler.h"
 
 void printHelp()
 {
@@ -17,24 +17,48 @@ void printHelp()
               << "  -E <E>          : associativity\n"
               << "  -b <b>          : number of block bits\n"
               << "  -o <outfile>    : output file for logging\n"
+              << "  -n <cores>      : number of cores, reads <tracefile>_proc0..N-1 (default 4)\n"
+              << "  --smt <n>       : hardware threads per core sharing its L1; core c runs traces\n"
+              << "                    _proc<c*n>.._proc<c*n+n-1> (default 1)\n"
+              << "  --smt-policy <p>: thread interleaving: rr (round-robin every cycle, default) or\n"
+              << "                    switch (stay on a thread until it misses or stalls)\n"
+              << "  --mshrs <n>     : MSHRs per cache, enables hit-under-miss (0 = blocking, default)\n"
+              << "  --prefetch <p>  : L1 prefetcher: none (default), nextline, stride, stream\n"
+              << "  --pf-degree <n> : blocks prefetched per trigger, 1 to 64 (default 1)\n"
+              << "  --pf-distance <n>: blocks ahead of the trigger to start prefetching, 1 to 64 (default 1)\n"
+              << "  --sb <n>        : store buffer entries per core (0 = none, default)\n"
+              << "  --sb-tso        : drain and coalesce the store buffer in program order (TSO)\n"
+              << "  --warmup <n>    : apply the first n accesses of every core without timing, then simulate the rest\n"
+              << "  --snapshot-dir <d>: cache warm-up snapshots in <d>, keyed by the warm-up accesses and cache geometry\n"
+              << "  --victim <n>    : fully associative victim cache entries per core (0 = none, default)\n"
+              << "  --page-map <p>  : virtual-to-physical page mapping: identity (default), random, color\n"
+              << "  --page-bits <n> : log2 of the page size, 12 (4 KB, default) to 30 (21 = 2 MB huge pages)\n"
+              << "  --tlb <n>       : TLB entries per core (0 = no TLB, default)\n"
+              << "  --tlb-assoc <n> : TLB associativity (default 4)\n"
+              << "  --tlb-latency <n>: page walk cycles after a TLB miss (default 30)\n"
+              << "  --way-predict   : probe the most recently used way of a set first\n"
+              << "  --shm <name>    : read accesses live from shared-memory rings <name>_proc<N> instead of -t\n"
+              << "  --shm-size <n>  : records per shared-memory ring (default 65536)\n"
+              << "  --interconnect <i>: bus (snooping, default), ring or mesh (directory MESI)\n"
+              << "  --mesh-cols <n> : mesh width (default: near-square)\n"
+              << "  --hop-latency <n>: ring/mesh cycles per hop (default 1)\n"
+              << "  --flit-bytes <n>: ring/mesh link width in bytes (default 16)\n"
+              << "  --mem-latency <n>: cycles to read a block from memory (default 100)\n"
+              << "  --wb-latency <n>: cycles to write a dirty block back (default 100)\n"
+              << "  --c2c-latency <n>: cache-to-cache transfer cycles per 4-byte word (default 2)\n"
+              << "  --upgr-latency <n>: cycles a BusUpgr holds the interconnect (default 0)\n"
+              << "  --bus-costs     : report interconnect cycles by transaction type, source and core\n"
+              << "  --pc-top <n>    : PCs listed per ranking for annotated traces (default 10)\n"
+              << "  --heatmap <csv> : per-set access/miss/eviction/invalidation counters and hot blocks;\n"
+              << "                    writes the sets x cores matrix to <csv> (\"-\" = report only)\n"
+              << "  --heat-sample <n>: hot-block sketches sample one in n events (default 1)\n"
+              << "  --heat-top <n>  : sets and blocks listed in the heat map report (default 10)\n"
               << "  -h              : print this help\n";
 }
 
-struct SimulationParams
-{
-    std::string baseTraceName;
-    long long int setIndexBits;
-    long long int associativity;
-    long long int blockBits;
-    std::string outFile;
-};
-
 SimulationParams parseArgs(long long int argc, char *argv[])
 {
-    SimulationParams params;
-    params.setIndexBits = 5;  // Default: 32 sets
-    params.associativity = 2; // Default: 2-way set associative
-    params.blockBits = 5;     // Default: 32-byte block size
+    SimulationParams params; // Defaults: 32 sets, 2-way, 32-byte blocks, blocking caches
 
     for (long long int i = 1; i < argc; i++)
     {
@@ -58,6 +82,143 @@ SimulationParams parseArgs(long long int argc, char *argv[])
         {
             params.outFile = argv[++i];
         }
+        else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+        {
+            params.numCores = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--smt") == 0 && i + 1 < argc)
+        {
+            params.threadsPerCore = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--smt-policy") == 0 && i + 1 < argc)
+        {
+            params.smtPolicy = argv[++i];
+        }
+        else if (strcmp(argv[i], "--mshrs") == 0 && i + 1 < argc)
+        {
+            params.mshrs = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--prefetch") == 0 && i + 1 < argc)
+        {
+            params.prefetcher = argv[++i];
+        }
+        else if (strcmp(argv[i], "--pf-degree") == 0 && i + 1 < argc)
+        {
+            params.prefetchDegree = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--pf-distance") == 0 && i + 1 < argc)
+        {
+            params.prefetchDistance = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--sb") == 0 && i + 1 < argc)
+        {
+            params.storeBufferDepth = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+        {
+            params.warmupAccesses = atoll(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--snapshot-dir") == 0 && i + 1 < argc)
+        {
+            params.snapshotDir = argv[++i];
+        }
+        else if (strcmp(argv[i], "--victim") == 0 && i + 1 < argc)
+        {
+            params.victimEntries = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--page-map") == 0 && i + 1 < argc)
+        {
+            params.pageMapping = argv[++i];
+        }
+        else if (strcmp(argv[i], "--page-bits") == 0 && i + 1 < argc)
+        {
+            params.pageBits = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--tlb") == 0 && i + 1 < argc)
+        {
+            params.tlbEntries = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--tlb-assoc") == 0 && i + 1 < argc)
+        {
+            params.tlbAssociativity = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--tlb-latency") == 0 && i + 1 < argc)
+        {
+            params.tlbMissLatency = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--way-predict") == 0)
+        {
+            params.wayPrediction = true;
+        }
+        else if (strcmp(argv[i], "--sb-tso") == 0)
+        {
+            params.storeBufferTSO = true;
+        }
+        else if (strcmp(argv[i], "--shm") == 0 && i + 1 < argc)
+        {
+            params.shmName = argv[++i];
+        }
+        else if (strcmp(argv[i], "--shm-size") == 0 && i + 1 < argc)
+        {
+            params.shmCapacity = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--interconnect") == 0 && i + 1 < argc)
+        {
+            params.interconnect = argv[++i];
+        }
+        else if (strcmp(argv[i], "--mesh-cols") == 0 && i + 1 < argc)
+        {
+            params.meshCols = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--hop-latency") == 0 && i + 1 < argc)
+        {
+            params.hopLatency = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--flit-bytes") == 0 && i + 1 < argc)
+        {
+            params.flitBytes = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--mem-latency") == 0 && i + 1 < argc)
+        {
+            params.busLatencies.memory = static_cast<uint32_t>(atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--wb-latency") == 0 && i + 1 < argc)
+        {
+            params.busLatencies.writeback = static_cast<uint32_t>(atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--c2c-latency") == 0 && i + 1 < argc)
+        {
+            params.busLatencies.transferPerWord = static_cast<uint32_t>(atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--upgr-latency") == 0 && i + 1 < argc)
+        {
+            params.busLatencies.upgrade = static_cast<uint32_t>(atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--bus-costs") == 0)
+        {
+            params.busCostReport = true;
+        }
+        else if (strcmp(argv[i], "--pc-top") == 0 && i + 1 < argc)
+        {
+            params.pcReportSize = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--heatmap") == 0 && i + 1 < argc)
+        {
+            params.heatMap = true;
+            params.heatMapFile = argv[++i];
+            if (params.heatMapFile == "-")
+            {
+                params.heatMapFile.clear();
+            }
+        }
+        else if (strcmp(argv[i], "--heat-sample") == 0 && i + 1 < argc)
+        {
+            params.heatSampleRate = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--heat-top") == 0 && i + 1 < argc)
+        {
+            params.heatTopK = atoi(argv[++i]);
+        }
         else if (strcmp(argv[i], "-h") == 0)
         {
             printHelp();
@@ -68,206 +229,224 @@ SimulationParams parseArgs(long long int argc, char *argv[])
     return params;
 }
 
-struct TraceEntry
+int main(int argc, char *argv[])
 {
-    bool isWrite;
-    uint32_t address;
-};
+    SimulationParams params = parseArgs(argc, argv);
+    if (params.baseTraceName.empty() && params.shmName.empty())
+    {
+        std::cerr << "Error: Base trace name not specified\n";
+        printHelp();
+        return 1;
+    }
 
-std::vector<TraceEntry> readTraceFile(const std::string &filename)
-{
-    std::vector<TraceEntry> entries;
-    std::ifstream file(filename);
-    if (!file.is_open())
+    if (params.prefetcher != "none" && !isKnownPrefetcher(params.prefetcher))
     {
-        std::cerr << "Error: Could not open trace file " << filename << std::endl;
-        exit(1);
+        std::cerr << "Error: Unknown prefetcher " << params.prefetcher << std::endl;
+        return 1;
     }
 
-    std::string line;
-    while (std::getline(file, line))
+    if (params.prefetchDegree < 1 || params.prefetchDegree > maxPrefetchDegree || params.prefetchDistance < 1 ||
+        params.prefetchDistance > maxPrefetchDegree)
     {
-        TraceEntry entry;
-        char type;
-        uint32_t address;
-        if (sscanf(line.c_str(), "%c %x", &type, &address) == 2)
-        {
-            entry.isWrite = (type == 'W');
-            entry.address = address;
-            entries.push_back(entry);
-        }
+        std::cerr << "Error: Prefetch degree and distance must be between 1 and " << maxPrefetchDegree << std::endl;
+        return 1;
     }
 
-    return entries;
-}
+    if (params.numCores <= 0)
+    {
+        std::cerr << "Error: Number of cores must be positive" << std::endl;
+        return 1;
+    }
 
-int main(int argc, char *argv[])
-{
-    SimulationParams params = parseArgs(argc, argv);
-    if (params.baseTraceName.empty())
+    // Line owners are kept in a byte
+    if (params.threadsPerCore <= 0 || params.threadsPerCore > 64)
     {
-        std::cerr << "Error: Base trace name not specified\n";
-        printHelp();
+        std::cerr << "Error: Threads per core must be between 1 and 64" << std::endl;
         return 1;
     }
 
-    const long long int numCores = 4;
-    uint64_t globalCycle = 0; // Single global cycle counter
-    std::vector<Cache> caches;
-    caches.reserve(numCores); // Pre-allocate space for all caches
-    std::vector<std::vector<TraceEntry>> traces(numCores);
+    if (params.smtPolicy != "rr" && params.smtPolicy != "switch")
+    {
+        std::cerr << "Error: Unknown SMT policy " << params.smtPolicy << std::endl;
+        return 1;
+    }
 
-    bool debugmode = false;
+    if (!isKnownInterconnect(params.interconnect))
+    {
+        std::cerr << "Error: Unknown interconnect " << params.interconnect << std::endl;
+        return 1;
+    }
 
-    // Create the bus
-    Bus bus(globalCycle);
-    bus.setDebugMode(debugmode); // Enable debug output for the bus
+    if (params.pcReportSize < 0)
+    {
+        std::cerr << "Error: --pc-top must not be negative" << std::endl;
+        return 1;
+    }
 
-    // Read traces and initialize caches
-    for (long long int core = 0; core < numCores; ++core)
+    // Negative values wrap around and are caught by the upper bound
+    const uint32_t maxLatency = 1000000;
+    if (params.busLatencies.memory > maxLatency || params.busLatencies.writeback > maxLatency ||
+        params.busLatencies.transferPerWord > maxLatency || params.busLatencies.upgrade > maxLatency)
     {
-        std::string traceFile = params.baseTraceName + "_proc" + std::to_string(core) + ".trace";
-        traces[core] = readTraceFile(traceFile);
-        caches.emplace_back(params.setIndexBits, params.associativity, params.blockBits, core, globalCycle);
-        caches[core].setBus(&bus);       // Connect cache to the bus
-        bus.registerCache(caches[core]); // Register cache with the bus
-        caches[core].setDebugMode(debugmode);
+        std::cerr << "Error: Latencies must be between 0 and " << maxLatency << std::endl;
+        return 1;
     }
 
-    // Simulate each core
-    std::vector<uint64_t> totalInstructions(numCores, 0);
-    std::vector<uint64_t> idleCycles(numCores, 0);
-    std::vector<uint64_t> execCycles(numCores, 0);
-    std::vector<size_t> currentInstructionIndex(numCores, 0);
-    bool allTracesComplete = false;
+    if (params.warmupAccesses < 0)
+    {
+        std::cerr << "Error: Warm-up length must not be negative" << std::endl;
+        return 1;
+    }
 
-    // Simulate all cores simultaneously
-    while (!allTracesComplete)
+    if (params.warmupAccesses > 0 && !params.shmName.empty())
     {
-        allTracesComplete = true;
+        std::cerr << "Error: --warmup needs trace files, it cannot be used with --shm" << std::endl;
+        return 1;
+    }
 
-        // Update bus state at the start of each cycle
-        if (bus.getRemainingCycles() == 1)
-        {
-            caches[bus.getCurrentRequestingCore()].stats.execCycles++;
-            totalInstructions[bus.getCurrentRequestingCore()]++;
-            currentInstructionIndex[bus.getCurrentRequestingCore()]++;
-        }
-        bus.updateBusState();
-        // Process each core in order of cache ID (for bus transaction priority)
-        for (long long int core = 0; core < numCores; ++core)
-        {
-            // Skip if this core has completed its trace
-            if (currentInstructionIndex[core] >= traces[core].size())
-            {
-                continue;
-            }
+    if (!params.snapshotDir.empty() && params.warmupAccesses == 0)
+    {
+        std::cerr << "Error: --snapshot-dir requires --warmup" << std::endl;
+        return 1;
+    }
+
+    if (!isKnownPageMapping(params.pageMapping))
+    {
+        std::cerr << "Error: Unknown page mapping " << params.pageMapping << std::endl;
+        return 1;
+    }
+
+    if (params.pageBits < 12 || params.pageBits > 30)
+    {
+        std::cerr << "Error: Page bits must be between 12 and 30" << std::endl;
+        return 1;
+    }
+
+    // Colors are set index bits of the physical address, so they must fit in it
+    if (params.pageMapping != "identity" &&
+        params.setIndexBits + params.blockBits > static_cast<long long int>(PageMapper::physicalAddressBits))
+    {
+        std::cerr << "Error: With --page-map, -s plus -b must not exceed the " << PageMapper::physicalAddressBits
+                  << "-bit physical address space" << std::endl;
+        return 1;
+    }
+
+    if (params.tlbEntries < 0 || params.tlbAssociativity <= 0 ||
+        (params.tlbEntries > 0 && params.tlbEntries % params.tlbAssociativity != 0))
+    {
+        std::cerr << "Error: TLB entries must be a multiple of the TLB associativity" << std::endl;
+        return 1;
+    }
+
+    if (params.tlbMissLatency < 0 || params.tlbMissLatency > 1000000)
+    {
+        std::cerr << "Error: TLB miss latency must be between 0 and 1000000" << std::endl;
+        return 1;
+    }
+
+    if (params.mshrs < 0 || params.storeBufferDepth < 0)
+    {
+        std::cerr << "Error: MSHR and store buffer counts must not be negative" << std::endl;
+        return 1;
+    }
+
+    if (params.victimEntries < 0)
+    {
+        std::cerr << "Error: Victim cache size must not be negative" << std::endl;
+        return 1;
+    }
+
+    if (params.heatSampleRate <= 0 || params.heatTopK <= 0)
+    {
+        std::cerr << "Error: --heat-sample and --heat-top must be positive" << std::endl;
+        return 1;
+    }
 
-            allTracesComplete = false;
-            const auto &entry = traces[core][currentInstructionIndex[core]];
+    if (params.meshCols < 0 || params.hopLatency <= 0 || params.flitBytes <= 0)
+    {
+        std::cerr << "Error: Mesh columns, hop latency and flit size must be positive" << std::endl;
+        return 1;
+    }
 
-            long long int result;
-            if (entry.isWrite)
+    if (!params.shmName.empty() && (params.shmCapacity <= 0 || params.shmCapacity > (1 << 30)))
+    {
+        std::cerr << "Error: Shared-memory ring size must be between 1 and " << (1 << 30) << std::endl;
+        return 1;
+    }
+
+    Simulator simulator(params);
+    if (!params.shmName.empty())
+    {
+        std::vector<std::unique_ptr<ShmRing>> rings;
+        std::vector<ShmRing *> ringPtrs;
+        for (long long int stream = 0; stream < simulator.getNumStreams(); ++stream)
+        {
+            rings.emplace_back(ShmRing::create(ShmRing::coreRingName(params.shmName, stream), params.shmCapacity));
+            if (!rings.back())
             {
-                result = caches[core].write(entry.address, core);
+                return 1;
             }
-            else
+            ringPtrs.push_back(rings.back().get());
+            std::cerr << "Waiting for producer on " << rings.back()->getName() << std::endl;
+        }
+        PROFILE_SCOPE(ProfilePhase::Simulation);
+        simulateFromRings(simulator, ringPtrs);
+    }
+    else
+    {
+        {
+            PROFILE_SCOPE(ProfilePhase::TraceLoad);
+            if (!simulator.loadTraces(params.baseTraceName))
             {
-                result = caches[core].read(entry.address, core);
+                return 1;
             }
-
-            // Update cycle counts based on result
-            switch (result)
+        }
+        if (params.warmupAccesses > 0)
+        {
+            PROFILE_SCOPE(ProfilePhase::Warmup);
+            if (!simulator.warmUp(params.warmupAccesses, params.snapshotDir))
             {
-            case 0:                                 // Hit
-                caches[core].stats.execCycles += 1; // 1 cycle for hit
-                if (entry.isWrite)
-                {
-                    caches[core].stats.writeCount++;
-                }
-                else
-                {
-                    caches[core].stats.readCount++;
-                }
-                totalInstructions[core]++;
-                currentInstructionIndex[core]++;
-                break;
-            case 1:                                 // Miss
-                caches[core].stats.execCycles += 1; // 1 cycle for the operation
-                if (entry.isWrite)
-                {
-                    caches[core].stats.writeCount++;
-                }
-                else
-                {
-                    caches[core].stats.readCount++;
-                }
-                break;
-            case -1:                             // Bus busy with another core
-                caches[core].stats.idleCycles++; // Core is idle waiting for bus
-                break;
-            case 2: // Bus in progress for this core
-                // No need to increment idle cycles as the core is waiting for its own transaction
-                caches[core].stats.execCycles++;
-                break;
+                return 1;
             }
         }
-
-        // Increment global cycle after processing all cores
-        // std::cout << "Global Cycle: " << globalCycle << std::endl;
-        globalCycle++;
+        PROFILE_SCOPE(ProfilePhase::Simulation);
+        simulator.run();
+    }
+    if (!simulator.getError().empty())
+    {
+        std::cerr << "Error: " << simulator.getError() << std::endl;
+        return 1;
     }
 
-    // Print simulation parameters
     std::ofstream outFile(params.outFile);
     if (!outFile.is_open()) {
         std::cerr << "Error: Could not open output file " << params.outFile << std::endl;
         return 1;
     }
-
-    outFile << "Simulation Parameters:\n";
-    outFile << "Trace Prefix: " << params.baseTraceName << "\n";
-    outFile << "Set Index Bits: " << params.setIndexBits << "\n";
-    outFile << "Associativity: " << params.associativity << "\n";
-    outFile << "Block Bits: " << params.blockBits << "\n";
-    outFile << "Block Size (Bytes): " << (1 << params.blockBits) << "\n";
-    outFile << "Number of Sets: " << (1 << params.setIndexBits) << "\n";
-    outFile << "Cache Size (KB per core): " << ((1 << params.setIndexBits) * params.associativity * (1 << params.blockBits)) / 1024 << "\n";
-    outFile << "MESI Protocol: Enabled\n";
-    outFile << "Write Policy: Write-back, Write-allocate\n";
-    outFile << "Replacement Policy: LRU\n";
-    outFile << "Bus: Central snooping bus\n\n";
-
-    // Print per-core statistics
-    for (long long int core = 0; core < numCores; ++core)
     {
-        const auto &stats = caches[core].getStats();
-        outFile << "Core " << core << " Statistics:\n";
-        outFile << "Total Instructions: " << totalInstructions[core] << "\n";
-        outFile << "Total Reads: " << stats.readCount << "\n";
-        outFile << "Total Writes: " << stats.writeCount << "\n";
-        outFile << "Total Execution Cycles: " << stats.execCycles << "\n";
-        outFile << "Total Idle Cycles: " << stats.idleCycles << "\n";
-        outFile << "Cache Hits: " << stats.hitCount << "\n";
-        outFile << "Cache Misses: " << stats.missCount << "\n";
-        outFile << "Cache Miss Rate: " << std::fixed << std::setprecision(2) << (stats.missCount * 100.0 / (stats.readCount + stats.writeCount)) << "%\n";
-        outFile << "Cache Evictions: " << stats.evictionCount << "\n";
-        outFile << "Writebacks: " << stats.writebackCount << "\n";
-        outFile << "Bus Invalidations: " << stats.invalidationCount << "\n";
-        outFile << "Data Traffic (Bytes): " << stats.busTrafficBytes << "\n\n";
-    }
+        PROFILE_SCOPE(ProfilePhase::Report);
+        simulator.printReport(outFile);
 
-    long long maximum_exec_cycles = 0;
-    for (long long int core = 0; core < numCores; ++core) {
-        if (caches[core].getStats().execCycles > maximum_exec_cycles) {
-            maximum_exec_cycles = caches[core].getStats().execCycles;
+        if (!params.heatMapFile.empty())
+        {
+            std::ofstream heatFile(params.heatMapFile);
+            if (!heatFile.is_open())
+            {
+                std::cerr << "Error: Could not open heat map file " << params.heatMapFile << std::endl;
+                return 1;
+            }
+            simulator.writeHeatMap(heatFile);
         }
     }
-    outFile << "Maximum Execution Cycles: " << maximum_exec_cycles << "\n";
-
-    // Print bus statistics
-    bus.printStats(outFile);
 
     outFile.close();
+#ifdef L1SIM_PROFILE
+    uint64_t simulatedAccesses = 0;
+    for (long long int core = 0; core < simulator.getNumCores(); ++core)
+    {
+        simulatedAccesses += simulator.getInstructions(core);
+    }
+    PROFILE_REPORT(std::cerr, simulatedAccesses, simulator.getCycle());
+#endif
     return 0;
-}
\ No newline at end of file
+}
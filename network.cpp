@@ -0,0 +1,416 @@
+#include "network.h"
+#include "bus.h"
+#include "profiler.h"
+#include <iomanip>
+#include <sstream>
+#include <fstream>
+#include <algorithm>
+
+static std::ofstream networkDebugFile;
+
+NetworkInterconnect::NetworkInterconnect(long long int nodes, uint32_t blockBits, uint64_t &cycle, uint32_t hopLatency, uint32_t flitBytes)
+    : caches(), globalCycle(cycle), debugMode(false), numNodes(nodes), blockBits(blockBits),
+      hopLatency(hopLatency == 0 ? 1 : hopLatency), flitBytes(flitBytes == 0 ? 16 : flitBytes), dataFlits(0), links(),
+      remainingCycles(nodes, 0), busy(nodes, false), servingUpgrade(nodes, false), activeRequester(-1),
+      netStats(), path()
+{
+    uint32_t blockSize = 1u << blockBits;
+    dataFlits = 1 + (blockSize + this->flitBytes - 1) / this->flitBytes;
+}
+
+void NetworkInterconnect::debugPrint(const std::string &msg) const
+{
+    if (!debugMode)
+        return;
+    if (!networkDebugFile.is_open())
+    {
+        networkDebugFile.open("debug.txt", std::ios::out | std::ios::app);
+    }
+    networkDebugFile << "[Network Cycle " << globalCycle << "] " << msg << std::endl;
+}
+
+void NetworkInterconnect::registerCache(Cache &cache)
+{
+    caches.push_back(std::ref(cache));
+}
+
+uint64_t NetworkInterconnect::send(long long int src, long long int dst, bool isData, uint64_t departure)
+{
+    uint32_t flits = isData ? dataFlits : 1;
+    if (isData)
+    {
+        netStats.dataMessages++;
+    }
+    else
+    {
+        netStats.controlMessages++;
+    }
+    if (src == dst)
+    {
+        return departure; // Local to the node, no network traversal
+    }
+
+    path.clear();
+    route(src, dst, path);
+    uint64_t t = departure;
+    for (size_t i = 0; i < path.size(); ++i)
+    {
+        // Wait for the link, then hold it for one cycle per flit
+        uint64_t start = links[path[i]].reserve(globalCycle, t, flits);
+        t = start + hopLatency;
+    }
+    netStats.flits += flits;
+    netStats.hops += path.size();
+    return t + flits - 1; // Tail flit arrives behind the head
+}
+
+bool NetworkInterconnect::broadcastTransaction(BusTransactionType type, uint64_t address, long long int requestingCore)
+{
+    PROFILE_SCOPE(ProfilePhase::Snoop);
+    stats.totalTransactions++;
+    switch (type)
+    {
+    case BusTransactionType::BusRd:
+        stats.busRdTransactions++;
+        break;
+    case BusTransactionType::BusRdX:
+        stats.busRdXTransactions++;
+        break;
+    case BusTransactionType::BusUpgr:
+        stats.busUpgrTransactions++;
+        break;
+    }
+
+    long long int home = static_cast<long long int>((address >> blockBits) % numNodes);
+    uint64_t now = globalCycle;
+    bool isWrite = (type != BusTransactionType::BusRd);
+    activeRequester = requestingCore;
+
+    // Directory lookup at the home node. The oracle directory reads the sharers
+    // from the caches; no message goes to a core that does not hold the block
+    uint64_t atHome = send(requestingCore, home, false, now);
+    std::vector<long long int> sharers;
+    std::vector<CacheState> sharerStates;
+    for (long long int i = 0; i < static_cast<long long int>(caches.size()); ++i)
+    {
+        if (i == requestingCore)
+            continue;
+        CacheState state = caches[i].get().getLineState(address);
+        if (state != CacheState::INVALID)
+        {
+            sharers.push_back(i);
+            sharerStates.push_back(state);
+        }
+    }
+
+    bool dataFromOtherCache = false;
+    uint64_t done = atHome;
+    if (!isWrite)
+    {
+        if (!sharers.empty())
+        {
+            // Forward to the first holder, which sends the block straight to the requester
+            netStats.forwards++;
+            uint64_t atOwner = send(home, sharers[0], false, atHome);
+            done = send(sharers[0], requestingCore, true, atOwner);
+            if (sharerStates[0] == CacheState::MODIFIED)
+            {
+                netStats.ownerWritebacks++;
+                send(sharers[0], home, true, atOwner);
+            }
+        }
+        else
+        {
+            done = send(home, requestingCore, true, atHome); // From the memory slice at the home node
+        }
+
+        bool dataRequested = true;
+        for (size_t i = 0; i < sharers.size(); ++i)
+        {
+            dataFromOtherCache |= caches[sharers[i]].get().processBusTransaction(address, false, requestingCore, dataRequested);
+            if (dataFromOtherCache)
+                dataRequested = false;
+        }
+    }
+    else
+    {
+        // Invalidate every sharer; each acknowledges to the requester
+        for (size_t i = 0; i < sharers.size(); ++i)
+        {
+            netStats.invalidations++;
+            uint64_t atSharer = send(home, sharers[i], false, atHome);
+            done = std::max(done, send(sharers[i], requestingCore, false, atSharer));
+            if (sharerStates[i] == CacheState::MODIFIED)
+            {
+                netStats.ownerWritebacks++;
+                send(sharers[i], home, true, atSharer);
+            }
+            dataFromOtherCache |= caches[sharers[i]].get().processBusTransaction(address, true, requestingCore, false);
+        }
+        if (type == BusTransactionType::BusRdX)
+        {
+            done = std::max(done, send(home, requestingCore, true, atHome));
+        }
+        else if (sharers.empty())
+        {
+            done = std::max(done, send(home, requestingCore, false, atHome)); // Ownership grant
+        }
+    }
+    activeRequester = -1;
+
+    uint64_t latency = done - now;
+    netStats.latencySum += latency;
+    netStats.maxLatency = std::max(netStats.maxLatency, latency);
+    servingUpgrade[requestingCore] = (type == BusTransactionType::BusUpgr);
+    if (latency > 0)
+    {
+        addRemainingCycles(static_cast<long long int>(latency), requestingCore);
+    }
+
+    if (debugMode)
+    {
+        std::stringstream ss;
+        ss << "Core " << requestingCore << " request for 0x" << std::hex << address << std::dec
+           << " via home " << home << ", " << sharers.size() << " sharer(s), network latency " << latency;
+        debugPrint(ss.str());
+    }
+    return dataFromOtherCache;
+}
+
+bool NetworkInterconnect::addRemainingCycles(long long int cycles, long long int coreId)
+{
+    // Costs a snooped cache charges while serving someone else's request are
+    // covered by the forwarded data message
+    if (activeRequester >= 0 && coreId != activeRequester)
+        return false;
+    remainingCycles[coreId] += cycles;
+    busy[coreId] = true;
+    return true;
+}
+
+void NetworkInterconnect::updateBusState()
+{
+    stats.elapsedCycles++;
+    for (long long int core = 0; core < numNodes; ++core)
+    {
+        if (busy[core] && --remainingCycles[core] <= 0)
+        {
+            busy[core] = false;
+            remainingCycles[core] = 0;
+            servingUpgrade[core] = false;
+        }
+    }
+}
+
+void NetworkInterconnect::printStats(std::ostream &out) const
+{
+    uint64_t messages = netStats.controlMessages + netStats.dataMessages;
+    out << "\nInterconnect Statistics:\n";
+    out << "Total Transactions: " << stats.totalTransactions << "\n";
+    out << "BusRd Transactions: " << stats.busRdTransactions << "\n";
+    out << "BusRdX Transactions: " << stats.busRdXTransactions << "\n";
+    out << "BusUpgr Transactions: " << stats.busUpgrTransactions << "\n";
+    out << "Total Bus Traffic (Bytes): " << stats.totalBusTraffic << "\n";
+    out << "Network Messages: " << messages << " (control " << netStats.controlMessages
+        << ", data " << netStats.dataMessages << ")\n";
+    out << "Flits Injected: " << netStats.flits << "\n";
+    out << "Average Hops per Message: " << std::fixed << std::setprecision(2)
+        << (messages > 0 ? static_cast<double>(netStats.hops) / messages : 0.0) << "\n";
+    out << "Invalidations Sent: " << netStats.invalidations << "\n";
+    out << "Forwarded Requests: " << netStats.forwards << "\n";
+    out << "Owner Writebacks: " << netStats.ownerWritebacks << "\n";
+    out << "Average Network Latency (cycles): " << std::fixed << std::setprecision(2)
+        << (stats.totalTransactions > 0 ? static_cast<double>(netStats.latencySum) / stats.totalTransactions : 0.0) << "\n";
+    out << "Max Network Latency (cycles): " << netStats.maxLatency << "\n";
+
+    // Utilization: share of cycles the link carried a flit
+    out << "Link Utilization:\n";
+    double peak = 0.0;
+    std::string peakLink = "-";
+    for (size_t i = 0; i < links.size(); ++i)
+    {
+        if (!links[i].present)
+            continue;
+        double utilization = globalCycle > 0 ? 100.0 * links[i].flits / globalCycle : 0.0;
+        out << "  " << links[i].name << ": " << links[i].flits << " flits, "
+            << std::fixed << std::setprecision(2) << utilization << "%\n";
+        if (utilization > peak)
+        {
+            peak = utilization;
+            peakLink = links[i].name;
+        }
+    }
+    out << "Peak Link Utilization: " << std::fixed << std::setprecision(2) << peak << "% (" << peakLink << ")\n";
+}
+
+uint64_t NetworkLink::reserve(uint64_t now, uint64_t earliest, uint32_t count)
+{
+    // Every taken cycle lies in [now, now + window), so cycles past the window are free
+    uint64_t start = earliest;
+    uint32_t run = 0;
+    while (run < count)
+    {
+        uint64_t cycle = start + run;
+        if (cycle < now + reserved.size() && reserved[cycle % reserved.size()] == cycle + 1)
+        {
+            start = cycle + 1; // Taken, look for a run after it
+            run = 0;
+        }
+        else
+        {
+            run++;
+        }
+    }
+    if (start + count > now + reserved.size())
+    {
+        grow(now, start + count - now);
+    }
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        reserved[(start + i) % reserved.size()] = start + i + 1;
+    }
+    flits += count;
+    return start;
+}
+
+void NetworkLink::grow(uint64_t now, uint64_t span)
+{
+    // Heavy contention queued flits further ahead than the window covers.
+    // Reservations before now are over and are dropped.
+    size_t size = reserved.size();
+    while (size < span)
+    {
+        size *= 2;
+    }
+    std::vector<uint64_t> wider(size, 0);
+    for (size_t i = 0; i < reserved.size(); ++i)
+    {
+        if (reserved[i] > now)
+        {
+            wider[(reserved[i] - 1) % size] = reserved[i];
+        }
+    }
+    reserved.swap(wider);
+}
+
+static std::string linkName(long long int from, long long int to)
+{
+    return "R" + std::to_string(from) + "->R" + std::to_string(to);
+}
+
+RingInterconnect::RingInterconnect(long long int nodes, uint32_t blockBits, uint64_t &cycle, uint32_t hopLatency, uint32_t flitBytes)
+    : NetworkInterconnect(nodes, blockBits, cycle, hopLatency, flitBytes)
+{
+    // Link 2n goes clockwise from node n, link 2n + 1 counter-clockwise
+    links.resize(2 * nodes);
+    for (long long int n = 0; n < nodes; ++n)
+    {
+        long long int next = (n + 1) % nodes;
+        long long int prev = (n + nodes - 1) % nodes;
+        links[2 * n] = NetworkLink(nodes > 1, linkName(n, next));
+        links[2 * n + 1] = NetworkLink(nodes > 2, linkName(n, prev)); // Two nodes share one pair of links
+    }
+}
+
+void RingInterconnect::route(long long int src, long long int dst, std::vector<size_t> &route) const
+{
+    long long int clockwise = (dst - src + numNodes) % numNodes;
+    bool goClockwise = (clockwise <= numNodes - clockwise) || numNodes <= 2;
+    long long int node = src;
+    while (node != dst)
+    {
+        if (goClockwise)
+        {
+            route.push_back(2 * node);
+            node = (node + 1) % numNodes;
+        }
+        else
+        {
+            route.push_back(2 * node + 1);
+            node = (node + numNodes - 1) % numNodes;
+        }
+    }
+}
+
+std::string RingInterconnect::describe() const
+{
+    std::stringstream ss;
+    ss << "Bidirectional ring, " << numNodes << " nodes, " << hopLatency << " cycle(s)/hop, "
+       << flitBytes << "-byte flits, directory MESI (home = block mod " << numNodes << ")";
+    return ss.str();
+}
+
+MeshInterconnect::MeshInterconnect(long long int nodes, uint32_t meshCols, uint32_t blockBits, uint64_t &cycle, uint32_t hopLatency, uint32_t flitBytes)
+    : NetworkInterconnect(nodes, blockBits, cycle, hopLatency, flitBytes), cols(meshCols), rows(0)
+{
+    if (cols == 0)
+    {
+        // Near-square: smallest width whose square holds every node
+        cols = 1;
+        while (static_cast<long long int>(cols) * cols < nodes)
+        {
+            cols++;
+        }
+    }
+    rows = static_cast<uint32_t>((nodes + cols - 1) / cols);
+
+    // Link 4r + d leaves router r towards east, west, north, south
+    const int dx[4] = {1, -1, 0, 0};
+    const int dy[4] = {0, 0, -1, 1};
+    links.resize(4 * static_cast<size_t>(rows) * cols);
+    for (uint32_t y = 0; y < rows; ++y)
+    {
+        for (uint32_t x = 0; x < cols; ++x)
+        {
+            long long int router = static_cast<long long int>(y) * cols + x;
+            for (int d = 0; d < 4; ++d)
+            {
+                long long int nx = static_cast<long long int>(x) + dx[d];
+                long long int ny = static_cast<long long int>(y) + dy[d];
+                bool present = nx >= 0 && ny >= 0 && nx < cols && ny < rows;
+                links[4 * router + d] = NetworkLink(present, present ? linkName(router, ny * cols + nx) : "");
+            }
+        }
+    }
+}
+
+void MeshInterconnect::route(long long int src, long long int dst, std::vector<size_t> &route) const
+{
+    long long int x = src % cols, y = src / cols;
+    long long int dstX = dst % cols, dstY = dst / cols;
+    while (x != dstX)
+    {
+        route.push_back(4 * (y * cols + x) + (dstX > x ? 0 : 1));
+        x += (dstX > x) ? 1 : -1;
+    }
+    while (y != dstY)
+    {
+        route.push_back(4 * (y * cols + x) + (dstY > y ? 3 : 2));
+        y += (dstY > y) ? 1 : -1;
+    }
+}
+
+std::string MeshInterconnect::describe() const
+{
+    std::stringstream ss;
+    ss << "2D mesh " << cols << "x" << rows << " (XY routing), " << numNodes << " nodes, " << hopLatency
+       << " cycle(s)/hop, " << flitBytes << "-byte flits, directory MESI (home = block mod " << numNodes << ")";
+    return ss.str();
+}
+
+bool isKnownInterconnect(const std::string &type)
+{
+    return type == "bus" || type == "ring" || type == "mesh";
+}
+
+Interconnect *createInterconnect(const std::string &type, long long int numCores, uint32_t blockBits, uint64_t &cycle,
+                                 uint32_t meshCols, uint32_t hopLatency, uint32_t flitBytes)
+{
+    if (type == "bus")
+        return new Bus(cycle);
+    if (type == "ring")
+        return new RingInterconnect(numCores, blockBits, cycle, hopLatency, flitBytes);
+    if (type == "mesh")
+        return new MeshInterconnect(numCores, meshCols, blockBits, cycle, hopLatency, flitBytes);
+    return nullptr;
+}
@@ -0,0 +1,128 @@
+#ifndef NETWORK_H
+#define NETWORK_H
+
+#include <vector>
+#include <cstdint>
+#include <string>
+#include <functional>
+#include "cache.h"
+#include "interconnect.h"
+
+// One directed link between neighbouring routers. A link carries one flit per
+// cycle; reservations are kept per cycle so a message can use a gap left
+// before a later message that was routed first.
+struct NetworkLink
+{
+    static const size_t initialWindow = 1024; // Cycles ahead of now covered before the window grows
+
+    bool present;                   // Mesh edge routers have fewer neighbours
+    std::string name;               // "R0->R1"
+    uint64_t flits;                 // Flits carried so far
+    std::vector<uint64_t> reserved; // reserved[c % size] == c + 1 if cycle c is taken, all taken cycles within size of now
+
+    NetworkLink() : present(false), name(), flits(0), reserved() {}
+    NetworkLink(bool present, const std::string &name) : present(present), name(name), flits(0), reserved(present ? initialWindow : 0, 0) {}
+    // First cycle at or after `earliest` of `count` consecutive free cycles, now taken
+    uint64_t reserve(uint64_t now, uint64_t earliest, uint32_t count);
+
+private:
+    void grow(uint64_t now, uint64_t span); // Widen the window to cover [now, now + span)
+};
+
+// Network statistics (bus-style transaction counts live in Interconnect::stats)
+struct NetworkStats
+{
+    uint64_t controlMessages; // Requests, forwards, invalidations, acks
+    uint64_t dataMessages;    // Block transfers and owner writebacks
+    uint64_t flits;
+    uint64_t hops;
+    uint64_t invalidations;   // Sent by home nodes to sharers
+    uint64_t forwards;        // Requests forwarded by a home node to the owner
+    uint64_t ownerWritebacks; // Dirty data returned to the home node on a downgrade or invalidation
+    uint64_t latencySum;      // Network part of the transaction latency (memory time excluded)
+    uint64_t maxLatency;
+};
+
+// Point-to-point network with one node (router, L1 and a slice of the directory
+// and memory) per core. Coherence is a directory MESI protocol: a miss goes to
+// the home node of the block (block mod nodes), which forwards it to the owner
+// or sends invalidations to the sharers, so only caches that hold the block are
+// sent messages. The directory is an oracle: it stores nothing, and the home
+// node reads the sharers and owner straight from the L1 states, so it is always
+// exact, never evicts entries and adds no lookup or occupancy time (eviction
+// notices are not sent either). State changes are applied when the request is
+// issued, as on the bus; the messages only decide how long the requesting core
+// waits. Messages reserve every link on their route for one cycle per flit, so
+// traffic that shares links queues behind earlier messages.
+class NetworkInterconnect : public Interconnect
+{
+protected:
+    std::vector<std::reference_wrapper<Cache>> caches;
+    uint64_t &globalCycle;
+    bool debugMode;
+    long long int numNodes;
+    uint32_t blockBits;
+    uint32_t hopLatency;     // Router + link cycles per hop
+    uint32_t flitBytes;
+    uint32_t dataFlits;      // Header flit plus the block
+    std::vector<NetworkLink> links;
+    std::vector<long long int> remainingCycles; // Per core: one outstanding transaction each
+    std::vector<bool> busy;
+    std::vector<bool> servingUpgrade; // The store behind the in-flight upgrade has already retired
+    long long int activeRequester;    // Set while a request is being processed
+    NetworkStats netStats;
+    std::vector<size_t> path;         // Scratch route
+
+    virtual void route(long long int src, long long int dst, std::vector<size_t> &route) const = 0;
+    // Send a message, returns the cycle its last flit arrives
+    uint64_t send(long long int src, long long int dst, bool isData, uint64_t departure);
+    void debugPrint(const std::string &msg) const;
+
+public:
+    NetworkInterconnect(long long int nodes, uint32_t blockBits, uint64_t &cycle, uint32_t hopLatency, uint32_t flitBytes);
+    void setDebugMode(bool enable) override { debugMode = enable; }
+    void registerCache(Cache &cache) override;
+    bool broadcastTransaction(BusTransactionType type, uint64_t address, long long int requestingCore) override;
+    bool addRemainingCycles(long long int cycles, long long int coreId) override;
+    void updateBusState() override;
+
+    bool isServing(long long int core) const override { return busy[core]; }
+    bool canIssue(long long int core) const override { return !busy[core]; }
+    bool missCompleting(long long int core) const override
+    {
+        return busy[core] && remainingCycles[core] == 1 && !servingUpgrade[core];
+    }
+
+    void printStats(std::ostream &out = std::cout) const override;
+    const NetworkStats &getNetworkStats() const { return netStats; }
+    const std::vector<NetworkLink> &getLinks() const { return links; }
+};
+
+// Bidirectional ring, messages take the shorter direction (clockwise on a tie)
+class RingInterconnect : public NetworkInterconnect
+{
+protected:
+    void route(long long int src, long long int dst, std::vector<size_t> &route) const override;
+
+public:
+    RingInterconnect(long long int nodes, uint32_t blockBits, uint64_t &cycle, uint32_t hopLatency, uint32_t flitBytes);
+    std::string describe() const override;
+};
+
+// 2D mesh with dimension-ordered (X then Y) routing. Node n sits at column
+// n % cols, row n / cols; a partial last row leaves routers without a core.
+class MeshInterconnect : public NetworkInterconnect
+{
+private:
+    uint32_t cols;
+    uint32_t rows;
+
+protected:
+    void route(long long int src, long long int dst, std::vector<size_t> &route) const override;
+
+public:
+    MeshInterconnect(long long int nodes, uint32_t cols, uint32_t blockBits, uint64_t &cycle, uint32_t hopLatency, uint32_t flitBytes);
+    std::string describe() const override;
+};
+
+#endif // NETWORK_H
@@ -0,0 +1,161 @@
+#include "prefetcher.h"
+
+void NextLinePrefetcher::onAccess(uint64_t block, bool isMiss, bool prefetchHit, std::vector<uint64_t> &candidates)
+{
+    // Tagged next-line: trigger on misses and on first use of a prefetched line
+    if (!isMiss && !prefetchHit)
+        return;
+    for (uint32_t i = 0; i < degree; ++i)
+    {
+        candidates.push_back(block + distance + i);
+    }
+}
+
+StridePrefetcher::StridePrefetcher(uint32_t degree, uint32_t distance, uint32_t blockBits, uint32_t tableSize)
+    : Prefetcher(degree, distance), table(tableSize), regionShift(blockBits < 12 ? 12 - blockBits : 0), useCounter(0)
+{
+    for (size_t i = 0; i < table.size(); ++i)
+    {
+        table[i].valid = false;
+    }
+}
+
+void StridePrefetcher::onAccess(uint64_t block, bool isMiss, bool prefetchHit, std::vector<uint64_t> &candidates)
+{
+    (void)isMiss;
+    (void)prefetchHit;
+    uint64_t region = block >> regionShift;
+    useCounter++;
+
+    // Find the stream for this region, or the LRU entry to replace
+    size_t victim = 0;
+    for (size_t i = 0; i < table.size(); ++i)
+    {
+        StreamEntry &entry = table[i];
+        if (entry.valid && entry.region == region)
+        {
+            int64_t stride = static_cast<int64_t>(block) - static_cast<int64_t>(entry.lastBlock);
+            if (stride != 0 && stride == entry.stride)
+            {
+                if (entry.confidence < 3)
+                    entry.confidence++;
+            }
+            else if (stride != 0)
+            {
+                entry.stride = stride;
+                entry.confidence = 0;
+            }
+            entry.lastBlock = block;
+            entry.lastUse = useCounter;
+
+            // Two confirmations before prefetching along the stride
+            if (entry.confidence >= 2)
+            {
+                for (uint32_t d = 0; d < degree; ++d)
+                {
+                    int64_t target = static_cast<int64_t>(block) + entry.stride * static_cast<int64_t>(distance + d);
+                    if (target >= 0)
+                    {
+                        candidates.push_back(static_cast<uint64_t>(target));
+                    }
+                }
+            }
+            return;
+        }
+        if (!table[victim].valid)
+            continue;
+        if (!entry.valid || entry.lastUse < table[victim].lastUse)
+        {
+            victim = i;
+        }
+    }
+
+    StreamEntry &entry = table[victim];
+    entry.valid = true;
+    entry.region = region;
+    entry.lastBlock = block;
+    entry.stride = 0;
+    entry.confidence = 0;
+    entry.lastUse = useCounter;
+}
+
+StreamBufferPrefetcher::StreamBufferPrefetcher(uint32_t degree, uint32_t distance, uint32_t numStreams)
+    : Prefetcher(degree, distance), streams(numStreams), useCounter(0)
+{
+    for (size_t i = 0; i < streams.size(); ++i)
+    {
+        streams[i].valid = false;
+    }
+}
+
+void StreamBufferPrefetcher::extend(Stream &stream, std::vector<uint64_t> &candidates)
+{
+    // Keep the window [expected + distance - 1, expected + distance + degree - 1) prefetched
+    uint64_t first = stream.expected + distance - 1;
+    uint64_t last = first + degree - 1;
+    uint64_t next = (stream.frontier + 1 > first) ? stream.frontier + 1 : first;
+    for (; next <= last; ++next)
+    {
+        candidates.push_back(next);
+        stream.frontier = next;
+    }
+}
+
+void StreamBufferPrefetcher::onAccess(uint64_t block, bool isMiss, bool prefetchHit, std::vector<uint64_t> &candidates)
+{
+    (void)prefetchHit;
+    useCounter++;
+
+    // Accesses inside a stream's window advance it
+    for (size_t i = 0; i < streams.size(); ++i)
+    {
+        Stream &stream = streams[i];
+        if (stream.valid && block >= stream.expected && block <= stream.frontier)
+        {
+            stream.expected = block + 1;
+            stream.lastUse = useCounter;
+            extend(stream, candidates);
+            return;
+        }
+    }
+
+    if (!isMiss)
+        return;
+
+    // A miss outside every stream allocates the LRU stream buffer
+    size_t victim = 0;
+    for (size_t i = 0; i < streams.size(); ++i)
+    {
+        if (!streams[i].valid)
+        {
+            victim = i;
+            break;
+        }
+        if (streams[i].lastUse < streams[victim].lastUse)
+        {
+            victim = i;
+        }
+    }
+    Stream &stream = streams[victim];
+    stream.valid = true;
+    stream.expected = block + 1;
+    stream.frontier = block;
+    stream.lastUse = useCounter;
+    extend(stream, candidates);
+}
+
+bool isKnownPrefetcher(const std::string &type)
+{
+    return type == "nextline" || type == "stride" || type == "stream";
+}
+
+Prefetcher *createPrefetcher(const std::string &type, uint32_t degree, uint32_t distance, uint32_t blockBits)
+{
+    if (type == "nextline")
+        return new NextLinePrefetcher(degree, distance);
+    if (type == "stride")
+        return new StridePrefetcher(degree, distance, blockBits);
+    if (type == "stream")
+        return new StreamBufferPrefetcher(degree, distance);
+    return nullptr;
+}
@@ -0,0 +1,93 @@
+#ifndef PREFETCHER_H
+#define PREFETCHER_H
+
+#include <vector>
+#include <cstdint>
+#include <string>
+
+// Prefetcher interface. Works on block addresses (address >> blockBits) so it
+// does not depend on the cache geometry.
+class Prefetcher
+{
+protected:
+    uint32_t degree;   // Number of blocks requested per trigger
+    uint32_t distance; // How many blocks ahead of the trigger the first prefetch lands
+
+public:
+    Prefetcher(uint32_t degree, uint32_t distance) : degree(degree), distance(distance) {}
+    virtual ~Prefetcher() {}
+
+    // Called for every demand access that the cache accepts. prefetchHit is true
+    // when the access hit a line brought in by a prefetch. Block addresses to
+    // prefetch are appended to candidates.
+    virtual void onAccess(uint64_t block, bool isMiss, bool prefetchHit, std::vector<uint64_t> &candidates) = 0;
+    virtual std::string name() const = 0;
+};
+
+// Fetches the next sequential block(s) on a miss or on a hit to a prefetched line
+class NextLinePrefetcher : public Prefetcher
+{
+public:
+    NextLinePrefetcher(uint32_t degree, uint32_t distance) : Prefetcher(degree, distance) {}
+    void onAccess(uint64_t block, bool isMiss, bool prefetchHit, std::vector<uint64_t> &candidates) override;
+    std::string name() const override { return "next-line"; }
+};
+
+// Per-stream stride detection. Prefetchers see block addresses only (pc=
+// annotations are not passed down), so a stream is a 4KB region.
+class StridePrefetcher : public Prefetcher
+{
+private:
+    struct StreamEntry
+    {
+        bool valid;
+        uint64_t region;
+        uint64_t lastBlock;
+        int64_t stride;
+        uint32_t confidence;
+        uint64_t lastUse;
+    };
+    std::vector<StreamEntry> table;
+    uint32_t regionShift; // Block bits to drop to get the region number
+    uint64_t useCounter;
+
+public:
+    StridePrefetcher(uint32_t degree, uint32_t distance, uint32_t blockBits, uint32_t tableSize = 16);
+    void onAccess(uint64_t block, bool isMiss, bool prefetchHit, std::vector<uint64_t> &candidates) override;
+    std::string name() const override { return "stride"; }
+};
+
+// Stream buffers: a miss allocates a sequential stream, accesses that follow
+// the stream advance it and keep `degree` blocks in flight ahead of it.
+// Prefetched blocks are filled into the L1 rather than a separate buffer.
+class StreamBufferPrefetcher : public Prefetcher
+{
+private:
+    struct Stream
+    {
+        bool valid;
+        uint64_t expected; // Next block the stream expects to be accessed
+        uint64_t frontier; // Furthest block already prefetched
+        uint64_t lastUse;
+    };
+    std::vector<Stream> streams;
+    uint64_t useCounter;
+
+    void extend(Stream &stream, std::vector<uint64_t> &candidates);
+
+public:
+    StreamBufferPrefetcher(uint32_t degree, uint32_t distance, uint32_t numStreams = 4);
+    void onAccess(uint64_t block, bool isMiss, bool prefetchHit, std::vector<uint64_t> &candidates) override;
+    std::string name() const override { return "stream"; }
+};
+
+// True for the names createPrefetcher() understands
+bool isKnownPrefetcher(const std::string &type);
+
+// Largest degree and distance; both must be at least 1
+const uint32_t maxPrefetchDegree = 64;
+
+// Create a prefetcher by name ("nextline", "stride", "stream"); returns nullptr for "none"
+Prefetcher *createPrefetcher(const std::string &type, uint32_t degree, uint32_t distance, uint32_t blockBits);
+
+#endif // PREFETCHER_H
@@ -0,0 +1,167 @@
+#include "profiler.h"
+
+#ifdef L1SIM_PROFILE
+
+#include <chrono>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <iomanip>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+namespace
+{
+const int counterCount = 3;
+const char *counterNames[counterCount] = {"instructions", "cache misses", "branch misses"};
+const uint64_t counterConfigs[counterCount] = {PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES,
+                                               PERF_COUNT_HW_BRANCH_MISSES};
+const char *phaseNames[profilePhaseCount] = {"Trace Load", "Warm-up", "Simulation", "Cache Access",
+                                             "Cache Tick", "Snoop", "Report"};
+
+struct PhaseStats
+{
+    uint64_t calls;
+    uint64_t nanoseconds;
+    uint64_t counters[counterCount];
+    std::chrono::steady_clock::time_point start;
+    uint64_t counterStart[counterCount];
+};
+
+struct ProfilerState
+{
+    bool initialized;
+    int group;                   // Leader fd, -1 if counters are unavailable
+    int counterIndex[counterCount]; // Position of each counter in a group read, -1 if it did not open
+    int opened;
+    std::string counterError;
+    PhaseStats phases[profilePhaseCount];
+};
+
+ProfilerState state;
+
+bool isTopLevel(ProfilePhase phase)
+{
+    return phase == ProfilePhase::TraceLoad || phase == ProfilePhase::Warmup ||
+           phase == ProfilePhase::Simulation || phase == ProfilePhase::Report;
+}
+
+int openCounter(uint64_t config, int group)
+{
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.disabled = (group == -1) ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, group, 0));
+}
+
+void initialize()
+{
+    state.initialized = true;
+    state.group = -1;
+    state.opened = 0;
+    for (int c = 0; c < counterCount; ++c)
+    {
+        state.counterIndex[c] = -1;
+        int fd = openCounter(counterConfigs[c], state.group);
+        if (fd < 0)
+        {
+            if (state.counterError.empty())
+                state.counterError = std::string(counterNames[c]) + ": " + strerror(errno);
+            continue;
+        }
+        if (state.group == -1)
+            state.group = fd;
+        state.counterIndex[c] = state.opened++;
+    }
+    if (state.group != -1)
+    {
+        ioctl(state.group, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(state.group, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+}
+
+void readCounters(uint64_t values[counterCount])
+{
+    uint64_t buffer[1 + counterCount] = {0};
+    if (state.group == -1 || read(state.group, buffer, sizeof(buffer)) < static_cast<ssize_t>(sizeof(uint64_t)))
+    {
+        memset(values, 0, sizeof(uint64_t) * counterCount);
+        return;
+    }
+    for (int c = 0; c < counterCount; ++c)
+    {
+        values[c] = state.counterIndex[c] >= 0 ? buffer[1 + state.counterIndex[c]] : 0;
+    }
+}
+} // namespace
+
+void Profiler::begin(ProfilePhase phase)
+{
+    if (!state.initialized)
+        initialize();
+    PhaseStats &stats = state.phases[static_cast<int>(phase)];
+    if (isTopLevel(phase))
+        readCounters(stats.counterStart);
+    stats.start = std::chrono::steady_clock::now();
+}
+
+void Profiler::end(ProfilePhase phase)
+{
+    PhaseStats &stats = state.phases[static_cast<int>(phase)];
+    stats.nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - stats.start).count();
+    stats.calls++;
+    if (isTopLevel(phase))
+    {
+        uint64_t now[counterCount];
+        readCounters(now);
+        for (int c = 0; c < counterCount; ++c)
+        {
+            stats.counters[c] += now[c] - stats.counterStart[c];
+        }
+    }
+}
+
+void Profiler::report(std::ostream &out, uint64_t accesses, uint64_t cycles)
+{
+    out << "\nSimulator Profile (wall time, inclusive: Snoop is part of Cache Access/Tick, which are part of Simulation):\n";
+    for (int p = 0; p < profilePhaseCount; ++p)
+    {
+        const PhaseStats &stats = state.phases[p];
+        if (stats.calls == 0)
+            continue;
+        out << "  " << phaseNames[p] << ": " << std::fixed << std::setprecision(2) << stats.nanoseconds / 1e6
+            << " ms in " << stats.calls << " calls";
+        if (isTopLevel(static_cast<ProfilePhase>(p)) && state.group != -1)
+        {
+            for (int c = 0; c < counterCount; ++c)
+            {
+                if (state.counterIndex[c] >= 0)
+                    out << ", " << stats.counters[c] << " " << counterNames[c];
+            }
+        }
+        out << "\n";
+    }
+    double simulationNs = static_cast<double>(state.phases[static_cast<int>(ProfilePhase::Simulation)].nanoseconds);
+    out << "Host ns per Simulated Access: " << std::fixed << std::setprecision(2)
+        << (accesses > 0 ? simulationNs / accesses : 0.0) << "\n";
+    out << "Host ns per Simulated Cycle: " << std::fixed << std::setprecision(2)
+        << (cycles > 0 ? simulationNs / cycles : 0.0) << "\n";
+    if (state.group == -1)
+    {
+        out << "Hardware Counters: unavailable (" << (state.counterError.empty() ? "not initialized" : state.counterError) << ")\n";
+    }
+    else if (!state.counterError.empty())
+    {
+        out << "Hardware Counters: partially unavailable (" << state.counterError << ")\n";
+    }
+}
+
+#endif // L1SIM_PROFILE
@@ -0,0 +1,59 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <cstdint>
+#include <iostream>
+
+// Built-in profiler of the simulator itself, compiled in with `make PROFILE=1`
+// (-DL1SIM_PROFILE). Without it the PROFILE_* macros expand to nothing.
+enum class ProfilePhase
+{
+    TraceLoad,   // Reading and parsing/decoding trace files
+    Warmup,      // Functional warm-up or snapshot load
+    Simulation,  // The cycle loop (ring waits included in --shm mode)
+    CacheAccess, // Cache::read/write of a core's current access
+    CacheTick,   // Per-cycle background work of the caches
+    Snoop,       // Coherence fan-out of a transaction to the other caches
+    Report,      // Writing the report and heat map
+};
+
+const int profilePhaseCount = 7;
+
+#ifdef L1SIM_PROFILE
+
+// Wall time and call counts for every phase. Top-level phases (trace load,
+// warm-up, simulation, report) also read the Linux perf_event counters; the
+// hot-path phases do not, as reading them costs far more than the code they
+// would measure.
+class Profiler
+{
+public:
+    static void begin(ProfilePhase phase);
+    static void end(ProfilePhase phase);
+    // accesses and cycles give the host time per simulated access and cycle
+    static void report(std::ostream &out, uint64_t accesses, uint64_t cycles);
+};
+
+class ProfileScope
+{
+private:
+    ProfilePhase phase;
+
+public:
+    explicit ProfileScope(ProfilePhase phase) : phase(phase) { Profiler::begin(phase); }
+    ~ProfileScope() { Profiler::end(phase); }
+};
+
+#define PROFILE_CONCAT2(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+#define PROFILE_SCOPE(phase) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(phase)
+#define PROFILE_REPORT(out, accesses, cycles) Profiler::report(out, accesses, cycles)
+
+#else
+
+#define PROFILE_SCOPE(phase)
+#define PROFILE_REPORT(out, accesses, cycles)
+
+#endif // L1SIM_PROFILE
+
+#endif // PROFILER_H
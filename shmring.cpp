@@ -0,0 +1,234 @@
+#include "shmring.h"
+#include "simulator.h"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <new>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "shared-memory ring needs lock-free 64-bit atomics");
+
+static const uint64_t ringMagic = 0x4c3153494d52494eULL; // "L1SIMRIN"
+static const uint32_t ringVersion = 1;
+
+ShmRing::ShmRing(const std::string &ringName, ShmRingHeader *ringHeader, size_t bytes, bool isOwner)
+    : name(ringName), header(ringHeader), records(reinterpret_cast<ShmRingRecord *>(ringHeader + 1)),
+      mappedBytes(bytes), owner(isOwner), cachedTail(0)
+{
+}
+
+ShmRing::~ShmRing()
+{
+    munmap(header, mappedBytes);
+    if (owner)
+    {
+        shm_unlink(name.c_str());
+    }
+}
+
+std::string ShmRing::coreRingName(const std::string &ringName, long long int core)
+{
+    std::string full = ringName + "_proc" + std::to_string(core);
+    return (full[0] == '/') ? full : "/" + full;
+}
+
+ShmRing *ShmRing::create(const std::string &ringName, uint32_t capacity)
+{
+    // Round up to a power of two so slots are addressed with a mask
+    uint32_t slots = 1;
+    while (slots < capacity)
+    {
+        slots <<= 1;
+    }
+
+    shm_unlink(ringName.c_str()); // Drop a stale ring left by a crashed run
+    int fd = shm_open(ringName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+    {
+        std::cerr << "Error: Could not create shared memory " << ringName << ": " << strerror(errno) << std::endl;
+        return nullptr;
+    }
+    size_t bytes = sizeof(ShmRingHeader) + static_cast<size_t>(slots) * sizeof(ShmRingRecord);
+    if (ftruncate(fd, bytes) != 0)
+    {
+        std::cerr << "Error: Could not size shared memory " << ringName << ": " << strerror(errno) << std::endl;
+        ::close(fd);
+        shm_unlink(ringName.c_str());
+        return nullptr;
+    }
+    void *mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mem == MAP_FAILED)
+    {
+        std::cerr << "Error: Could not map shared memory " << ringName << ": " << strerror(errno) << std::endl;
+        shm_unlink(ringName.c_str());
+        return nullptr;
+    }
+
+    ShmRingHeader *ringHeader = new (mem) ShmRingHeader;
+    ringHeader->magic.store(0, std::memory_order_relaxed);
+    ringHeader->capacity = slots;
+    ringHeader->version = ringVersion;
+    ringHeader->head.store(0, std::memory_order_relaxed);
+    ringHeader->tail.store(0, std::memory_order_relaxed);
+    ringHeader->closed.store(0, std::memory_order_relaxed);
+    // Publish the magic last: a producer only trusts the ring once it sees it
+    ringHeader->magic.store(ringMagic, std::memory_order_release);
+    return new ShmRing(ringName, ringHeader, bytes, true);
+}
+
+ShmRing *ShmRing::attach(const std::string &ringName)
+{
+    int fd = shm_open(ringName.c_str(), O_RDWR, 0);
+    if (fd < 0)
+    {
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(ShmRingHeader))
+    {
+        ::close(fd);
+        return nullptr;
+    }
+    size_t bytes = static_cast<size_t>(st.st_size);
+    void *mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mem == MAP_FAILED)
+    {
+        return nullptr;
+    }
+
+    ShmRingHeader *ringHeader = static_cast<ShmRingHeader *>(mem);
+    if (ringHeader->magic.load(std::memory_order_acquire) != ringMagic || ringHeader->version != ringVersion ||
+        bytes < sizeof(ShmRingHeader) + static_cast<size_t>(ringHeader->capacity) * sizeof(ShmRingRecord))
+    {
+        munmap(mem, bytes);
+        return nullptr;
+    }
+    ShmRing *ring = new ShmRing(ringName, ringHeader, bytes, false);
+    ring->cachedTail = ringHeader->tail.load(std::memory_order_acquire);
+    return ring;
+}
+
+bool ShmRing::push(bool isWrite, uint64_t address)
+{
+    uint64_t head = header->head.load(std::memory_order_relaxed);
+    if (head - cachedTail >= header->capacity)
+    {
+        cachedTail = header->tail.load(std::memory_order_acquire);
+        if (head - cachedTail >= header->capacity)
+        {
+            return false; // Full
+        }
+    }
+    ShmRingRecord &record = records[head & (header->capacity - 1)];
+    record.address = address;
+    record.isWrite = isWrite ? 1 : 0;
+    header->head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+void ShmRing::close()
+{
+    header->closed.store(1, std::memory_order_release);
+}
+
+size_t ShmRing::pop(std::vector<TraceEntry> &out, size_t maxEntries)
+{
+    uint64_t tail = header->tail.load(std::memory_order_relaxed);
+    uint64_t head = header->head.load(std::memory_order_acquire);
+    size_t count = static_cast<size_t>(head - tail);
+    if (count > maxEntries)
+    {
+        count = maxEntries;
+    }
+    uint32_t mask = header->capacity - 1;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const ShmRingRecord &record = records[(tail + i) & mask];
+        TraceEntry entry = {record.isWrite != 0, record.address, 0, -1, 0};
+        out.push_back(entry);
+    }
+    header->tail.store(tail + count, std::memory_order_release);
+    return count;
+}
+
+bool ShmRing::isEmpty() const
+{
+    return header->head.load(std::memory_order_acquire) == header->tail.load(std::memory_order_relaxed);
+}
+
+bool ShmRing::isFinished() const
+{
+    // Check closed before emptiness so a final push followed by close() is not missed
+    return header->closed.load(std::memory_order_acquire) != 0 && isEmpty();
+}
+
+void simulateFromRings(Simulator &simulator, std::vector<ShmRing *> &rings)
+{
+    // A core can retire two accesses in one cycle (a blocking miss completing
+    // at the start of the cycle, then a hit), so keep at least this many queued
+    // or the core would see an empty queue that the trace file would not have
+    const size_t lookahead = 2;
+    const size_t batchSize = 4096;
+    std::vector<TraceEntry> batch;
+    batch.reserve(batchSize);
+    std::vector<bool> finished(rings.size(), false);
+    size_t openRings = rings.size();
+
+    // A simulation stopped on an error consumes nothing more; the caller reports it
+    while (openRings > 0 && simulator.getError().empty())
+    {
+        // Pull whatever has arrived and note cores that are running dry
+        bool starved = false;
+        for (size_t core = 0; core < rings.size(); ++core)
+        {
+            if (finished[core])
+                continue;
+            batch.clear();
+            rings[core]->pop(batch, batchSize);
+            if (!batch.empty())
+            {
+                simulator.pushAccesses(core, batch.data(), batch.size());
+            }
+            if (rings[core]->isFinished())
+            {
+                finished[core] = true;
+                openRings--;
+            }
+            else if (simulator.getPendingAccesses(core) < lookahead)
+            {
+                starved = true;
+            }
+        }
+
+        if (openRings == 0)
+        {
+            break;
+        }
+        if (starved)
+        {
+            sched_yield(); // Wait for the producer instead of letting the core look finished
+            continue;
+        }
+
+        // Every open core has enough work: simulate until one of them runs low
+        bool low = false;
+        while (!low && simulator.getError().empty())
+        {
+            simulator.step(1);
+            for (size_t core = 0; core < rings.size() && !low; ++core)
+            {
+                low = !finished[core] && simulator.getPendingAccesses(core) < lookahead;
+            }
+        }
+    }
+
+    // Every cycle stepped above still had work queued, so finishing with run()
+    // executes the same cycles as a trace-file simulation
+    simulator.run();
+}
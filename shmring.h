@@ -0,0 +1,77 @@
+#ifndef SHMRING_H
+#define SHMRING_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class Simulator;
+struct TraceEntry;
+
+// One memory reference as written by the producer
+struct ShmRingRecord
+{
+    uint64_t address;
+    uint32_t isWrite;
+    uint32_t reserved;
+};
+
+// Layout at the start of each shared-memory object, followed by `capacity`
+// records. head/tail are free-running counters on separate cache lines so the
+// producer and consumer never write the same line.
+struct ShmRingHeader
+{
+    std::atomic<uint64_t> magic; // Stored last by the creator (release), so a producer that sees it sees the rest
+    uint32_t version;
+    uint32_t capacity; // Power of two
+    alignas(64) std::atomic<uint64_t> head;   // Next slot the producer writes
+    alignas(64) std::atomic<uint64_t> tail;   // Next slot the consumer reads
+    alignas(64) std::atomic<uint32_t> closed; // Producer will push nothing more
+};
+
+// Single-producer/single-consumer lock-free ring in POSIX shared memory.
+// The simulator creates one ring per core named "<name>_proc<N>" and an
+// instrumented process attaches to it and pushes its memory references.
+class ShmRing
+{
+private:
+    std::string name;
+    ShmRingHeader *header;
+    ShmRingRecord *records;
+    size_t mappedBytes;
+    bool owner;         // Created the object, unlinks it on destruction
+    uint64_t cachedTail; // Producer's last view of tail, avoids reading the shared line on every push
+
+    ShmRing(const std::string &name, ShmRingHeader *header, size_t mappedBytes, bool owner);
+
+public:
+    ~ShmRing();
+    ShmRing(const ShmRing &) = delete;
+    ShmRing &operator=(const ShmRing &) = delete;
+
+    static ShmRing *create(const std::string &name, uint32_t capacity); // Consumer side, nullptr on failure
+    static ShmRing *attach(const std::string &name);                    // Producer side, nullptr on failure
+    static std::string coreRingName(const std::string &name, long long int core);
+
+    // Producer
+    bool push(bool isWrite, uint64_t address); // false if the ring is full
+    void close();
+
+    // Consumer
+    size_t pop(std::vector<TraceEntry> &out, size_t maxEntries); // Appends up to maxEntries, returns the count
+    bool isEmpty() const;
+    bool isFinished() const; // Closed by the producer and fully drained
+
+    const std::string &getName() const { return name; }
+    uint32_t getCapacity() const { return header->capacity; }
+};
+
+// Feed the simulator from its per-core rings until every producer has closed
+// its ring, then run the remaining accesses to completion. A core whose queue
+// runs dry waits for its producer rather than being treated as finished, so
+// the result matches simulating the same references from trace files.
+void simulateFromRings(Simulator &simulator, std::vector<ShmRing *> &rings);
+
+#endif // SHMRING_H
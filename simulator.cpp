@@ -0,0 +1,1034 @@
+#include "simulator.h"
+#include "snapshot.h"
+#include "tracecodec.h"
+#include "profiler.h"
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <cerrno>
+#include <algorithm>
+#include <iterator>
+
+// An annotation value: a whole token of digits in the given base, at most maxValue
+static bool parseNumber(const char *value, int base, unsigned long long maxValue, unsigned long long &result)
+{
+    if (!isxdigit(static_cast<unsigned char>(*value)))
+        return false; // strtoull would skip blanks and accept a sign
+    char *end = nullptr;
+    errno = 0;
+    result = strtoull(value, &end, base);
+    return errno == 0 && end != value && result <= maxValue &&
+           (*end == '\0' || *end == ' ' || *end == '\t' || *end == '\r');
+}
+
+// Parse the key=value annotations that may follow the address: gap and tid are
+// decimal, pc is hex. Returns false on a known key whose value is not a number.
+static bool parseAnnotations(const char *text, TraceEntry &entry)
+{
+    while (*text)
+    {
+        while (*text == ' ' || *text == '\t' || *text == '\r')
+            text++;
+        unsigned long long number = 0;
+        if (strncmp(text, "gap=", 4) == 0)
+        {
+            if (!parseNumber(text + 4, 10, UINT32_MAX, number))
+                return false;
+            entry.gap = static_cast<uint32_t>(number);
+        }
+        else if (strncmp(text, "pc=", 3) == 0)
+        {
+            if (!parseNumber(text + 3, 16, UINT64_MAX, number))
+                return false;
+            entry.pc = number;
+        }
+        else if (strncmp(text, "tid=", 4) == 0)
+        {
+            if (!parseNumber(text + 4, 10, INT32_MAX, number))
+                return false;
+            entry.tid = static_cast<int32_t>(number);
+        }
+        // Skip to the next token (also skips unknown keys)
+        while (*text && *text != ' ' && *text != '\t')
+            text++;
+    }
+    return true;
+}
+
+bool readTraceFile(const std::string &filename, std::vector<TraceEntry> &entries)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open())
+    {
+        std::cerr << "Error: Could not open trace file " << filename << std::endl;
+        return false;
+    }
+
+    // Compressed traces are decoded in one pass over the whole file
+    char magic[4];
+    if (file.read(magic, sizeof(magic)) && isCompressedTrace(magic, sizeof(magic)))
+    {
+        std::string data(magic, sizeof(magic));
+        data.append(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        if (!decodeTrace(data.data(), data.size(), entries))
+        {
+            std::cerr << "Error: Corrupt compressed trace file " << filename << std::endl;
+            return false;
+        }
+        return true;
+    }
+    file.clear();
+    file.seekg(0);
+
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(file, line))
+    {
+        lineNumber++;
+        TraceEntry entry = {false, 0, 0, -1, 0};
+        char type;
+        unsigned long long address;
+        int consumed = 0;
+        if (sscanf(line.c_str(), "%c %llx%n", &type, &address, &consumed) == 2)
+        {
+            entry.isWrite = (type == 'W');
+            entry.address = address;
+            if (!parseAnnotations(line.c_str() + consumed, entry))
+            {
+                std::cerr << "Error: Bad annotation value in trace file " << filename << " line " << lineNumber << ": "
+                          << line << std::endl;
+                return false;
+            }
+            entries.push_back(entry);
+        }
+    }
+
+    return true;
+}
+
+Simulator::Simulator(const SimulationParams &simParams)
+    : params(simParams), numCores(simParams.numCores), threadsPerCore(simParams.threadsPerCore),
+      numStreams(simParams.numCores * simParams.threadsPerCore), switchOnMiss(simParams.smtPolicy == "switch"),
+      globalCycle(0),
+      bus(createInterconnect(simParams.interconnect, simParams.numCores, simParams.blockBits, globalCycle,
+                             simParams.meshCols, simParams.hopLatency, simParams.flitBytes)),
+      caches(),
+      prefetchers(simParams.numCores), traces(numStreams),
+      currentInstructionIndex(numStreams, 0), totalInstructions(simParams.numCores, 0),
+      computeInstructions(simParams.numCores, 0), gapProgress(numStreams, 0), gapDone(numStreams, 0),
+      issueThread(simParams.numCores, 0), missStream(simParams.numCores, 0), threadStats(numStreams, ThreadStats()),
+      pageMapper(), tlbs(), translatedIndex(numStreams, 0), physicalAddress(numStreams, 0), walkRemaining(numStreams, 0),
+      pcProfile(), threadProfile(), heatMap()
+{
+    if (params.pageMapping != "identity" || params.tlbEntries > 0)
+    {
+        long long int colorBits = params.setIndexBits + params.blockBits - params.pageBits;
+        pageMapper.reset(new PageMapper(pageMappingPolicy(params.pageMapping), static_cast<uint32_t>(params.pageBits),
+                                        static_cast<uint32_t>(colorBits > 0 ? colorBits : 0)));
+    }
+    if (params.tlbEntries > 0)
+    {
+        tlbs.assign(numCores, TLB(static_cast<uint32_t>(params.tlbEntries), static_cast<uint32_t>(params.tlbAssociativity)));
+    }
+
+    if (params.heatMap)
+    {
+        // Sketch capacity well above what is reported keeps the listed counts tight
+        heatMap.reset(new HeatMap(params.heatSampleRate, 4 * params.heatTopK));
+    }
+
+    bool debugmode = false;
+    bus->setDebugMode(debugmode); // Enable debug output for the bus
+    bus->setLatencies(params.busLatencies);
+
+    caches.reserve(numCores); // Pre-allocate space for all caches, the bus keeps references
+    for (long long int core = 0; core < numCores; ++core)
+    {
+        caches.emplace_back(params.setIndexBits, params.associativity, params.blockBits, core, globalCycle);
+        caches[core].setBus(bus.get());   // Connect cache to the bus
+        bus->registerCache(caches[core]); // Register cache with the bus
+        caches[core].setDebugMode(debugmode);
+        caches[core].setMSHRCount(params.mshrs);
+        caches[core].setStoreBuffer(params.storeBufferDepth, params.storeBufferTSO);
+        caches[core].setVictimCache(params.victimEntries);
+        caches[core].setWayPrediction(params.wayPrediction);
+        caches[core].setHeatMap(heatMap.get());
+        caches[core].setThreads(static_cast<uint32_t>(threadsPerCore));
+        missStream[core] = core * threadsPerCore;
+        if (params.prefetcher != "none")
+        {
+            prefetchers[core].reset(createPrefetcher(params.prefetcher, params.prefetchDegree, params.prefetchDistance, params.blockBits));
+            caches[core].setPrefetcher(prefetchers[core].get());
+        }
+    }
+}
+
+bool Simulator::loadTraces(const std::string &baseTraceName)
+{
+    for (long long int stream = 0; stream < numStreams; ++stream)
+    {
+        std::string traceFile = baseTraceName + "_proc" + std::to_string(stream) + ".trace";
+        std::ifstream probe(traceFile);
+        if (!probe.is_open() && std::ifstream(traceFile + "z").is_open())
+        {
+            traceFile += "z"; // Only the compressed copy was kept
+        }
+        if (!readTraceFile(traceFile, traces[stream]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Simulator::warmUp(uint64_t accesses, const std::string &snapshotDir)
+{
+    if (globalCycle != 0)
+    {
+        std::cerr << "Error: Warm-up must happen before the first simulated cycle" << std::endl;
+        return false;
+    }
+    params.warmupAccesses = static_cast<long long int>(accesses);
+    params.snapshotDir = snapshotDir;
+
+    WarmupSnapshot snapshot;
+    snapshot.setIndexBits = static_cast<uint32_t>(params.setIndexBits);
+    snapshot.associativity = static_cast<uint32_t>(params.associativity);
+    snapshot.blockBits = static_cast<uint32_t>(params.blockBits);
+    snapshot.numCores = static_cast<uint32_t>(numCores);
+    snapshot.warmupAccesses = accesses;
+
+    std::vector<size_t> warmEnd(numStreams);
+    for (long long int stream = 0; stream < numStreams; ++stream)
+    {
+        warmEnd[stream] = currentInstructionIndex[stream] + std::min<uint64_t>(accesses, getPendingAccesses(stream));
+    }
+
+    // Physical addresses of the warm-up accesses. Pages are mapped (and TLBs
+    // filled) in the round-robin order of the warm-up even when the caches come
+    // from a snapshot, so later page allocations do not depend on the snapshot.
+    std::vector<std::vector<uint64_t>> warmAddresses(numStreams);
+    bool remaining = true;
+    for (size_t step = 0; remaining; ++step)
+    {
+        remaining = false;
+        for (long long int stream = 0; stream < numStreams; ++stream)
+        {
+            size_t index = currentInstructionIndex[stream] + step;
+            if (index >= warmEnd[stream])
+                continue;
+            remaining = true;
+            uint64_t address = traces[stream][index].address;
+            warmAddresses[stream].push_back(pageMapper ? warmTranslate(stream / threadsPerCore, address) : address);
+        }
+    }
+    if (!error.empty())
+    {
+        std::cerr << "Error: " << error << std::endl;
+        return false;
+    }
+
+    // FNV-1a over the warm-up region of every stream
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (long long int stream = 0; stream < numStreams; ++stream)
+    {
+        for (size_t i = currentInstructionIndex[stream]; i <= warmEnd[stream]; ++i)
+        {
+            // A per-stream terminator keeps the split between streams part of the key
+            size_t offset = i - currentInstructionIndex[stream];
+            uint64_t word = i < warmEnd[stream] ? (warmAddresses[stream][offset] << 1 | (traces[stream][i].isWrite ? 1 : 0)) : ~0ULL;
+            for (int byte = 0; byte < 8; ++byte)
+            {
+                hash = (hash ^ ((word >> (8 * byte)) & 0xff)) * 0x100000001b3ULL;
+            }
+        }
+    }
+    snapshot.traceHash = hash;
+
+    std::string path = snapshotDir.empty() ? "" : snapshotPath(snapshotDir, snapshot);
+    WarmupSnapshot saved;
+    if (!path.empty() && readSnapshot(path, saved) && saved.sameKey(snapshot))
+    {
+        snapshot.lines.swap(saved.lines);
+        warmupSource = "loaded from " + path;
+    }
+    else
+    {
+        // Round-robin over the streams, one access each, with MESI done directly on the caches
+        uint64_t stamp = 0;
+        remaining = true;
+        for (size_t step = 0; remaining; ++step)
+        {
+            remaining = false;
+            for (long long int stream = 0; stream < numStreams; ++stream)
+            {
+                size_t index = currentInstructionIndex[stream] + step;
+                if (index >= warmEnd[stream])
+                    continue;
+                remaining = true;
+                long long int core = stream / threadsPerCore;
+                bool isWrite = traces[stream][index].isWrite;
+                uint64_t address = warmAddresses[stream][step];
+                CacheState state = caches[core].getLineState(address);
+                if (isWrite || state == CacheState::INVALID)
+                {
+                    bool shared = false;
+                    for (long long int other = 0; other < numCores; ++other)
+                    {
+                        if (other != core && caches[other].getLineState(address) != CacheState::INVALID)
+                        {
+                            shared = true;
+                            caches[other].warmSnoop(address, isWrite);
+                        }
+                    }
+                    state = isWrite ? CacheState::MODIFIED : (shared ? CacheState::SHARED : CacheState::EXCLUSIVE);
+                }
+                caches[core].warmAccess(address, state, ++stamp);
+            }
+        }
+
+        for (long long int core = 0; core < numCores; ++core)
+        {
+            caches[core].exportLines(snapshot.lines);
+        }
+        if (!path.empty())
+        {
+            if (!writeSnapshot(path, snapshot))
+            {
+                std::cerr << "Error: Could not write warm-up snapshot " << path << std::endl;
+                return false;
+            }
+            warmupSource = "saved to " + path;
+        }
+        else
+        {
+            warmupSource = "not cached";
+        }
+    }
+
+    // Loading the exported lines back makes a run that built the snapshot
+    // behave exactly like one that reuses it
+    size_t linesPerCore = static_cast<size_t>(params.associativity) << params.setIndexBits;
+    for (long long int core = 0; core < numCores; ++core)
+    {
+        caches[core].importLines(&snapshot.lines[core * linesPerCore]);
+    }
+    for (long long int stream = 0; stream < numStreams; ++stream)
+    {
+        currentInstructionIndex[stream] = warmEnd[stream];
+    }
+    for (TLB &tlb : tlbs)
+    {
+        tlb.resetStats();
+    }
+    return true;
+}
+
+void Simulator::compact(long long int stream)
+{
+    // Everything queued so far has retired; drop it so long co-simulations do not grow without bound
+    traces[stream].clear();
+    currentInstructionIndex[stream] = 0;
+    gapDone[stream] = 0;
+    translatedIndex[stream] = 0;
+}
+
+uint64_t Simulator::warmTranslate(long long int core, uint64_t address)
+{
+    if (!tlbs.empty())
+    {
+        tlbs[core].lookup(address >> params.pageBits);
+    }
+    uint64_t physical = address;
+    if (!pageMapper->translate(address, physical))
+    {
+        outOfFrames(address);
+    }
+    return physical;
+}
+
+void Simulator::outOfFrames(uint64_t address)
+{
+    if (!error.empty())
+        return;
+    std::stringstream ss;
+    ss << "No free " << (params.pageMapping == "color" ? "frame of its color" : "physical frame") << " for page 0x"
+       << std::hex << (address >> params.pageBits) << std::dec << " after mapping " << pageMapper->getMappedPages()
+       << " pages of the " << PageMapper::physicalAddressBits << "-bit physical memory"
+       << (params.pageMapping == "color" ? " (fewer -s/-b bits leave more frames per color)" : " (use smaller pages)");
+    error = ss.str();
+}
+
+long long int Simulator::selectStream(long long int core) const
+{
+    for (long long int i = 0; i < threadsPerCore; ++i)
+    {
+        long long int stream = core * threadsPerCore + (issueThread[core] + i) % threadsPerCore;
+        if (currentInstructionIndex[stream] < traces[stream].size())
+        {
+            return stream;
+        }
+    }
+    return -1;
+}
+
+void Simulator::advanceThread(long long int core, long long int stream, bool switchThread)
+{
+    // Round-robin hands the next slot to the following thread, switch-on-miss only when this one cannot proceed
+    long long int thread = stream % threadsPerCore;
+    issueThread[core] = (!switchOnMiss || switchThread) ? (thread + 1) % threadsPerCore : thread;
+}
+
+void Simulator::retire(long long int core, long long int stream)
+{
+    totalInstructions[core]++;
+    threadStats[stream].instructions++;
+    currentInstructionIndex[stream]++;
+}
+
+void Simulator::profileAccess(const TraceEntry &entry, long long int result, uint64_t misses, uint64_t invalidations)
+{
+    AccessProfile *profiles[2] = {entry.pc != 0 ? &pcProfile[entry.pc] : nullptr,
+                                  entry.tid >= 0 ? &threadProfile[entry.tid] : nullptr};
+    for (AccessProfile *profile : profiles)
+    {
+        if (!profile)
+            continue;
+        if (result == -1 || result == 2)
+        {
+            profile->stallCycles++;
+        }
+        else
+        {
+            profile->accesses++;
+        }
+        profile->misses += misses;
+        profile->invalidations += invalidations;
+    }
+}
+
+void Simulator::pushAccesses(long long int stream, const TraceEntry *entries, size_t count)
+{
+    if (currentInstructionIndex[stream] >= traces[stream].size())
+    {
+        compact(stream);
+    }
+    traces[stream].insert(traces[stream].end(), entries, entries + count);
+}
+
+bool Simulator::cycle()
+{
+    if (!error.empty())
+    {
+        return true;
+    }
+    bool allTracesComplete = true;
+
+    // Update bus state at the start of each cycle
+    // (non-blocking caches retire misses when the MSHR is allocated; prefetches and store drains retire nothing)
+    if (params.mshrs == 0)
+    {
+        for (long long int core = 0; core < numCores; ++core)
+        {
+            if (bus->missCompleting(core) && !caches[core].hasBackgroundTransaction())
+            {
+                caches[core].stats.execCycles++;
+                retire(core, missStream[core]);
+            }
+        }
+    }
+    bus->updateBusState();
+    // Process each core in order of cache ID (for bus transaction priority)
+    for (long long int core = 0; core < numCores; ++core)
+    {
+        {
+            PROFILE_SCOPE(ProfilePhase::CacheTick);
+            caches[core].tick();
+        }
+
+        // Skip if every thread of this core has completed its trace
+        long long int stream = selectStream(core);
+        if (stream < 0)
+        {
+            if (caches[core].hasPendingWork())
+            {
+                allTracesComplete = false;
+            }
+            continue;
+        }
+
+        allTracesComplete = false;
+        const auto &entry = traces[stream][currentInstructionIndex[stream]];
+
+        // Non-memory instructions ahead of the access execute one per cycle
+        if (entry.gap > 0 && gapDone[stream] != currentInstructionIndex[stream] + 1)
+        {
+            caches[core].stats.execCycles++;
+            computeInstructions[core]++;
+            if (++gapProgress[stream] >= entry.gap)
+            {
+                gapProgress[stream] = 0;
+                gapDone[stream] = currentInstructionIndex[stream] + 1;
+            }
+            if (threadsPerCore > 1)
+            {
+                advanceThread(core, stream, false);
+            }
+            continue;
+        }
+
+        // Translation: a TLB miss walks the page table before the access can issue
+        uint64_t address = entry.address;
+        if (pageMapper)
+        {
+            if (translatedIndex[stream] != currentInstructionIndex[stream] + 1)
+            {
+                translatedIndex[stream] = currentInstructionIndex[stream] + 1;
+                if (!pageMapper->translate(entry.address, physicalAddress[stream]))
+                {
+                    outOfFrames(entry.address);
+                    return true;
+                }
+                if (!tlbs.empty() && !tlbs[core].lookup(entry.address >> params.pageBits))
+                {
+                    walkRemaining[stream] = params.tlbMissLatency;
+                }
+            }
+            if (walkRemaining[stream] > 0)
+            {
+                walkRemaining[stream]--;
+                caches[core].stats.execCycles++;
+                tlbs[core].stats.walkCycles++;
+                if (threadsPerCore > 1)
+                {
+                    threadStats[stream].stallCycles++;
+                    advanceThread(core, stream, true);
+                }
+                continue;
+            }
+            address = physicalAddress[stream];
+        }
+
+        bool profiled = entry.pc != 0 || entry.tid >= 0;
+        long long int hitsBefore = caches[core].stats.hitCount;
+        long long int missesBefore = caches[core].stats.missCount;
+        long long int invalidationsBefore = caches[core].stats.invalidationCount;
+        long long int result;
+        {
+            PROFILE_SCOPE(ProfilePhase::CacheAccess);
+            caches[core].setActiveThread(static_cast<uint32_t>(stream % threadsPerCore));
+            if (entry.isWrite)
+            {
+                result = caches[core].write(address, core);
+            }
+            else
+            {
+                result = caches[core].read(address, core);
+            }
+        }
+        if (heatMap && (result == 0 || result == 1 || result == 3))
+        {
+            caches[core].recordAccess(address);
+        }
+        if (profiled)
+        {
+            profileAccess(entry, result, caches[core].stats.missCount - missesBefore,
+                          caches[core].stats.invalidationCount - invalidationsBefore);
+        }
+        if (threadsPerCore > 1)
+        {
+            ThreadStats &thread = threadStats[stream];
+            long long int misses = caches[core].stats.missCount - missesBefore;
+            bool stalled = result == -1 || result == 2;
+            thread.hits += caches[core].stats.hitCount - hitsBefore;
+            thread.misses += misses;
+            thread.stallCycles += stalled ? 1 : 0;
+            advanceThread(core, stream, stalled || misses > 0);
+        }
+
+        // Update cycle counts based on result
+        switch (result)
+        {
+        case 0:                                 // Hit
+            caches[core].stats.execCycles += 1; // 1 cycle for hit
+            if (entry.isWrite)
+            {
+                caches[core].stats.writeCount++;
+            }
+            else
+            {
+                caches[core].stats.readCount++;
+            }
+            retire(core, stream);
+            break;
+        case 1:                                 // Miss
+            caches[core].stats.execCycles += 1; // 1 cycle for the operation
+            missStream[core] = stream;          // Retired when the bus completes it
+            if (entry.isWrite)
+            {
+                caches[core].stats.writeCount++;
+            }
+            else
+            {
+                caches[core].stats.readCount++;
+            }
+            break;
+        case -1:                             // Bus busy with another core
+            caches[core].stats.idleCycles++; // Core is idle waiting for bus
+            break;
+        case 2: // Bus in progress for this core
+            // No need to increment idle cycles as the core is waiting for its own transaction
+            caches[core].stats.execCycles++;
+            break;
+        case 3:                                 // Accepted by an MSHR or the store buffer, core moves on
+            caches[core].stats.execCycles += 1;
+            if (entry.isWrite)
+            {
+                caches[core].stats.writeCount++;
+            }
+            else
+            {
+                caches[core].stats.readCount++;
+            }
+            retire(core, stream);
+            break;
+        }
+    }
+
+    // Prefetches go last, so they never take the bus from a demand access of the same cycle
+    if (prefetchers[0])
+    {
+        PROFILE_SCOPE(ProfilePhase::CacheTick);
+        for (long long int core = 0; core < numCores; ++core)
+        {
+            caches[core].tickPrefetcher();
+        }
+    }
+
+    // Increment global cycle after processing all cores
+    globalCycle++;
+    return allTracesComplete;
+}
+
+bool Simulator::step(uint64_t cycles)
+{
+    // Finished once a cycle found nothing left to do, as in run(), so stepping
+    // until step() returns true ends on the same cycle as run()
+    bool finished = cycles == 0 && isDone();
+    for (uint64_t i = 0; i < cycles; ++i)
+    {
+        finished = cycle();
+    }
+    return finished;
+}
+
+void Simulator::run(uint64_t cycleLimit)
+{
+    // Simulate all cores simultaneously
+    while (globalCycle < cycleLimit && !cycle())
+    {
+    }
+}
+
+bool Simulator::isDone() const
+{
+    if (!error.empty())
+    {
+        return true;
+    }
+    for (long long int stream = 0; stream < numStreams; ++stream)
+    {
+        if (currentInstructionIndex[stream] < traces[stream].size())
+        {
+            return false;
+        }
+    }
+    for (long long int core = 0; core < numCores; ++core)
+    {
+        if (caches[core].hasPendingWork())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Simulator::printReport(std::ostream &outFile) const
+{
+    // Print simulation parameters
+    outFile << "Simulation Parameters:\n";
+    if (!params.shmName.empty())
+    {
+        outFile << "Trace Source: shared-memory rings " << params.shmName << "_proc<N>\n";
+    }
+    else
+    {
+        outFile << "Trace Prefix: " << params.baseTraceName << "\n";
+    }
+    outFile << "Set Index Bits: " << params.setIndexBits << "\n";
+    outFile << "Associativity: " << params.associativity << "\n";
+    outFile << "Block Bits: " << params.blockBits << "\n";
+    outFile << "Block Size (Bytes): " << (1 << params.blockBits) << "\n";
+    outFile << "Number of Sets: " << (1 << params.setIndexBits) << "\n";
+    outFile << "Cache Size (KB per core): " << ((1 << params.setIndexBits) * params.associativity * (1 << params.blockBits)) / 1024 << "\n";
+    outFile << "MESI Protocol: Enabled\n";
+    outFile << "Write Policy: Write-back, Write-allocate\n";
+    outFile << "Replacement Policy: LRU\n";
+    if (!warmupSource.empty())
+    {
+        outFile << "Warm-up: first " << params.warmupAccesses << " accesses per " << (threadsPerCore > 1 ? "thread" : "core")
+                << ", functional (" << warmupSource << ")\n";
+    }
+    if (threadsPerCore > 1)
+    {
+        outFile << "SMT: " << threadsPerCore << " threads per core, "
+                << (switchOnMiss ? "switch-on-miss" : "round-robin") << " interleaving\n";
+    }
+    if (pageMapper)
+    {
+        long long int pageKB = (1LL << params.pageBits) / 1024;
+        std::string pageSize = std::to_string(pageKB) + " KB";
+        if (pageKB >= 1024 * 1024)
+        {
+            pageSize = std::to_string(pageKB / (1024 * 1024)) + " GB";
+        }
+        else if (pageKB >= 1024)
+        {
+            pageSize = std::to_string(pageKB / 1024) + " MB";
+        }
+        outFile << "Page Mapping: " << params.pageMapping << ", " << pageSize << " pages";
+        if (params.pageMapping == "color")
+        {
+            long long int colorBits = params.setIndexBits + params.blockBits - params.pageBits;
+            outFile << ", " << (1LL << (colorBits > 0 ? colorBits : 0)) << " colors";
+        }
+        outFile << "\n";
+    }
+    if (!tlbs.empty())
+    {
+        outFile << "TLB: " << params.tlbEntries << " entries per core, " << params.tlbAssociativity << "-way, "
+                << params.tlbMissLatency << "-cycle page walk\n";
+    }
+    if (params.mshrs > 0)
+    {
+        outFile << "MSHRs per Cache: " << params.mshrs << " (non-blocking, hit-under-miss)\n";
+    }
+    if (params.storeBufferDepth > 0)
+    {
+        outFile << "Store Buffer: " << params.storeBufferDepth << " entries, "
+                << (params.storeBufferTSO ? "TSO" : "relaxed") << " ordering\n";
+    }
+    if (params.victimEntries > 0)
+    {
+        outFile << "Victim Cache: " << params.victimEntries << " entries, fully associative\n";
+    }
+    if (params.wayPrediction)
+    {
+        outFile << "Way Prediction: MRU\n";
+    }
+    if (params.prefetcher != "none" && prefetchers[0])
+    {
+        outFile << "Prefetcher: " << prefetchers[0]->name() << " (degree " << params.prefetchDegree
+                << ", distance " << params.prefetchDistance << ")\n";
+    }
+    const BusLatencies defaults;
+    const BusLatencies &lat = params.busLatencies;
+    if (lat.memory != defaults.memory || lat.writeback != defaults.writeback ||
+        lat.transferPerWord != defaults.transferPerWord || lat.upgrade != defaults.upgrade)
+    {
+        outFile << "Latencies (cycles): memory " << lat.memory << ", writeback " << lat.writeback
+                << ", cache-to-cache " << lat.transferPerWord << " per word, upgrade " << lat.upgrade << "\n";
+    }
+    if (params.interconnect == "bus")
+    {
+        outFile << "Bus: " << bus->describe() << "\n\n";
+    }
+    else
+    {
+        outFile << "Interconnect: " << bus->describe() << "\n\n";
+    }
+
+    bool annotatedGaps = false;
+    for (long long int core = 0; core < numCores; ++core)
+    {
+        annotatedGaps |= computeInstructions[core] > 0;
+    }
+
+    // Print per-core statistics
+    for (long long int core = 0; core < numCores; ++core)
+    {
+        const auto &stats = caches[core].getStats();
+        outFile << "Core " << core << " Statistics:\n";
+        outFile << "Total Instructions: " << totalInstructions[core] << "\n";
+        if (annotatedGaps)
+        {
+            outFile << "Non-memory Instructions: " << computeInstructions[core] << "\n";
+        }
+        outFile << "Total Reads: " << stats.readCount << "\n";
+        outFile << "Total Writes: " << stats.writeCount << "\n";
+        outFile << "Total Execution Cycles: " << stats.execCycles << "\n";
+        outFile << "Total Idle Cycles: " << stats.idleCycles << "\n";
+        outFile << "Cache Hits: " << stats.hitCount << "\n";
+        outFile << "Cache Misses: " << stats.missCount << "\n";
+        outFile << "Cache Miss Rate: " << std::fixed << std::setprecision(2) << (stats.missCount * 100.0 / (stats.readCount + stats.writeCount)) << "%\n";
+        outFile << "Cache Evictions: " << stats.evictionCount << "\n";
+        outFile << "Writebacks: " << stats.writebackCount << "\n";
+        outFile << "Bus Invalidations: " << stats.invalidationCount << "\n";
+        outFile << "Data Traffic (Bytes): " << stats.busTrafficBytes << "\n";
+        if (params.mshrs > 0)
+        {
+            outFile << "MSHR Merged Misses: " << stats.mshrMergedMisses << "\n";
+            outFile << "MSHR Stall Cycles: " << stats.mshrStallCycles << "\n";
+            outFile << "Average MSHR Occupancy: " << std::fixed << std::setprecision(2)
+                    << (stats.mshrSampledCycles > 0 ? static_cast<double>(stats.mshrOccupancySum) / stats.mshrSampledCycles : 0.0) << "\n";
+            outFile << "Peak MSHR Occupancy: " << stats.mshrOccupancyPeak << "\n";
+        }
+        if (params.storeBufferDepth > 0)
+        {
+            outFile << "Store Buffer Coalesced Stores: " << stats.sbCoalesced << "\n";
+            outFile << "Store Buffer Forwarded Loads: " << stats.sbForwarded << "\n";
+            outFile << "Store Buffer Full Stall Cycles: " << stats.sbStallCycles << "\n";
+            outFile << "Store Buffer Peak Occupancy: " << stats.sbOccupancyPeak << "\n";
+        }
+        if (params.victimEntries > 0)
+        {
+            outFile << "Victim Cache Hits: " << stats.victimHits << "\n";
+            outFile << "Victim Cache Evictions: " << stats.victimEvictions << "\n";
+        }
+        if (params.wayPrediction)
+        {
+            // Without prediction every lookup compares all tags of the set
+            long long int baseline = stats.wayPredLookups * params.associativity;
+            outFile << "Way Prediction Accuracy: " << std::fixed << std::setprecision(2)
+                    << (stats.wayPredLookups > 0 ? 100.0 * stats.wayPredHits / stats.wayPredLookups : 0.0) << "%\n";
+            outFile << "Tag Checks: " << stats.tagChecks << " (" << baseline << " without prediction)\n";
+            outFile << "Tag Checks Saved: " << std::fixed << std::setprecision(2)
+                    << (baseline > 0 ? 100.0 * (baseline - stats.tagChecks) / baseline : 0.0) << "%\n";
+        }
+        if (params.prefetcher != "none")
+        {
+            // Accuracy: useful / issued. Coverage: misses removed / misses without prefetching.
+            // Timeliness: useful prefetches that arrived before the demand access.
+            double issued = static_cast<double>(stats.prefetchIssued);
+            double useful = static_cast<double>(stats.prefetchUseful);
+            outFile << "Prefetches Issued: " << stats.prefetchIssued << "\n";
+            outFile << "Useful Prefetches: " << stats.prefetchUseful << "\n";
+            outFile << "Late Prefetches: " << stats.prefetchLate << "\n";
+            outFile << "Unused Prefetches: " << stats.prefetchUnused << "\n";
+            outFile << "Prefetched Lines Invalidated: " << stats.prefetchInvalidations << "\n";
+            outFile << "Prefetch Accuracy: " << std::fixed << std::setprecision(2)
+                    << (issued > 0 ? 100.0 * useful / issued : 0.0) << "%\n";
+            outFile << "Prefetch Coverage: " << std::fixed << std::setprecision(2)
+                    << (useful + stats.missCount > 0 ? 100.0 * useful / (useful + stats.missCount) : 0.0) << "%\n";
+            outFile << "Prefetch Timeliness: " << std::fixed << std::setprecision(2)
+                    << (useful > 0 ? 100.0 * (useful - stats.prefetchLate) / useful : 0.0) << "%\n";
+        }
+        if (!tlbs.empty())
+        {
+            const TLBStats &tlb = tlbs[core].stats;
+            outFile << "TLB Hits: " << tlb.hits << "\n";
+            outFile << "TLB Misses: " << tlb.misses << "\n";
+            outFile << "TLB Miss Rate: " << std::fixed << std::setprecision(2)
+                    << (tlb.hits + tlb.misses > 0 ? 100.0 * tlb.misses / (tlb.hits + tlb.misses) : 0.0) << "%\n";
+            outFile << "Page Walk Cycles: " << tlb.walkCycles << "\n";
+        }
+        if (threadsPerCore > 1)
+        {
+            // Inter-thread evictions: lines this thread brought in that a fill of a sibling thread pushed out
+            for (long long int thread = 0; thread < threadsPerCore; ++thread)
+            {
+                const ThreadStats &ts = threadStats[core * threadsPerCore + thread];
+                outFile << "Thread " << thread << " (trace " << core * threadsPerCore + thread << "): "
+                        << ts.instructions << " accesses, " << ts.hits << " hits, " << ts.misses << " misses ("
+                        << std::fixed << std::setprecision(2)
+                        << (ts.instructions > 0 ? 100.0 * ts.misses / ts.instructions : 0.0) << "%), "
+                        << ts.stallCycles << " stall cycles, "
+                        << caches[core].getInterThreadEvictions(static_cast<uint32_t>(thread)) << " inter-thread evictions\n";
+            }
+        }
+        outFile << "\n";
+    }
+
+    long long maximum_exec_cycles = 0;
+    for (long long int core = 0; core < numCores; ++core) {
+        if (caches[core].getStats().execCycles > maximum_exec_cycles) {
+            maximum_exec_cycles = caches[core].getStats().execCycles;
+        }
+    }
+    outFile << "Maximum Execution Cycles: " << maximum_exec_cycles << "\n";
+    if (pageMapper && params.pageMapping != "identity")
+    {
+        outFile << "Pages Mapped: " << pageMapper->getMappedPages() << "\n";
+    }
+
+    // Print bus statistics
+    bus->printStats(outFile);
+    if (params.busCostReport)
+    {
+        bus->printCostBreakdown(outFile);
+    }
+    printProfile(outFile);
+    printHeatMap(outFile);
+}
+
+void Simulator::printHeatMap(std::ostream &out) const
+{
+    if (!heatMap)
+        return;
+
+    // Per-set totals over all cores
+    uint32_t numSets = caches[0].getNumSets();
+    std::vector<CacheSet> totals(numSets);
+    for (uint32_t set = 0; set < numSets; ++set)
+    {
+        totals[set].accessCount = totals[set].missCount = totals[set].evictionCount = totals[set].invalidationCount = 0;
+        for (long long int core = 0; core < numCores; ++core)
+        {
+            const CacheSet &s = caches[core].getSet(set);
+            totals[set].accessCount += s.accessCount;
+            totals[set].missCount += s.missCount;
+            totals[set].evictionCount += s.evictionCount;
+            totals[set].invalidationCount += s.invalidationCount;
+        }
+    }
+
+    std::vector<uint32_t> order(numSets);
+    long long int totalMisses = 0, maxMisses = 0;
+    for (uint32_t set = 0; set < numSets; ++set)
+    {
+        order[set] = set;
+        totalMisses += totals[set].missCount;
+        maxMisses = std::max(maxMisses, totals[set].missCount);
+    }
+    std::stable_sort(order.begin(), order.end(), [&totals](uint32_t a, uint32_t b)
+                     { return totals[a].missCount > totals[b].missCount; });
+
+    out << "\nSet Heat Map:\n";
+    out << "Hottest Sets by Misses:\n";
+    for (size_t i = 0; i < order.size() && i < static_cast<size_t>(params.heatTopK); ++i)
+    {
+        const CacheSet &s = totals[order[i]];
+        out << "  Set " << order[i] << ": " << s.missCount << " misses, " << s.accessCount << " accesses, "
+            << s.evictionCount << " evictions, " << s.invalidationCount << " invalidations\n";
+    }
+    out << "Set Miss Imbalance (max/mean): " << std::fixed << std::setprecision(2)
+        << (totalMisses > 0 ? static_cast<double>(maxMisses) * numSets / totalMisses : 0.0) << "\n";
+
+    // Hot blocks come from the sampled sketches, so their counts are estimates
+    out << "Hot Block Sampling: 1 in " << heatMap->getSampleRate() << " events\n";
+    const HeatEvent events[heatEventCount] = {HeatEvent::Miss, HeatEvent::Invalidation, HeatEvent::Eviction, HeatEvent::Access};
+    for (HeatEvent event : events)
+    {
+        out << "Hot Blocks by " << heatEventName(event) << ":\n";
+        for (const TopKSketch::Entry &entry : heatMap->hottest(event, params.heatTopK))
+        {
+            out << "  0x" << std::hex << (entry.key << params.blockBits) << std::dec << ": ~" << entry.count;
+            if (entry.error > 0)
+            {
+                out << " (at least " << entry.count - entry.error << ")";
+            }
+            out << "\n";
+        }
+    }
+}
+
+void Simulator::writeHeatMap(std::ostream &out) const
+{
+    static const char *columns[heatEventCount] = {"accesses", "misses", "evictions", "invalidations"};
+    out << "set";
+    for (long long int core = 0; core < numCores; ++core)
+    {
+        for (int e = 0; e < heatEventCount; ++e)
+        {
+            out << ",core" << core << "_" << columns[e];
+        }
+    }
+    out << "\n";
+    for (uint32_t set = 0; set < caches[0].getNumSets(); ++set)
+    {
+        out << set;
+        for (long long int core = 0; core < numCores; ++core)
+        {
+            const CacheSet &s = caches[core].getSet(set);
+            out << "," << s.accessCount << "," << s.missCount << "," << s.evictionCount << "," << s.invalidationCount;
+        }
+        out << "\n";
+    }
+}
+
+// Entries with a non-zero metric, largest first (ties by key so reports are stable)
+template <typename Key>
+static std::vector<std::pair<Key, AccessProfile>> rankProfiles(const std::unordered_map<Key, AccessProfile> &profiles,
+                                                              uint64_t AccessProfile::*metric, size_t limit)
+{
+    std::vector<std::pair<Key, AccessProfile>> ranked;
+    for (const auto &entry : profiles)
+    {
+        if (entry.second.*metric > 0)
+        {
+            ranked.push_back(entry);
+        }
+    }
+    std::sort(ranked.begin(), ranked.end(), [metric](const std::pair<Key, AccessProfile> &a, const std::pair<Key, AccessProfile> &b)
+              { return a.second.*metric != b.second.*metric ? a.second.*metric > b.second.*metric : a.first < b.first; });
+    if (ranked.size() > limit)
+    {
+        ranked.resize(limit);
+    }
+    return ranked;
+}
+
+void Simulator::printProfile(std::ostream &out) const
+{
+    if (!pcProfile.empty())
+    {
+        struct Ranking
+        {
+            const char *title;
+            const char *unit;
+            uint64_t AccessProfile::*metric;
+        };
+        const Ranking rankings[3] = {{"Misses", "misses", &AccessProfile::misses},
+                                     {"Invalidations", "invalidations", &AccessProfile::invalidations},
+                                     {"Bus Stall Cycles", "stall cycles", &AccessProfile::stallCycles}};
+
+        out << "\nPer-PC Statistics:\n";
+        out << "Annotated PCs: " << pcProfile.size() << "\n";
+        for (const Ranking &ranking : rankings)
+        {
+            uint64_t total = 0;
+            for (const auto &entry : pcProfile)
+            {
+                total += entry.second.*ranking.metric;
+            }
+            out << "Top PCs by " << ranking.title << ":\n";
+            for (const auto &entry : rankProfiles(pcProfile, ranking.metric, params.pcReportSize))
+            {
+                out << "  0x" << std::hex << entry.first << std::dec << ": " << entry.second.*ranking.metric << " "
+                    << ranking.unit << " (" << std::fixed << std::setprecision(2)
+                    << 100.0 * entry.second.*ranking.metric / total << "%), " << entry.second.accesses << " accesses\n";
+            }
+        }
+    }
+
+    if (!threadProfile.empty())
+    {
+        std::vector<int32_t> tids;
+        for (const auto &entry : threadProfile)
+        {
+            tids.push_back(entry.first);
+        }
+        std::sort(tids.begin(), tids.end());
+        out << "\nPer-Thread Statistics:\n";
+        for (int32_t tid : tids)
+        {
+            const AccessProfile &profile = threadProfile.at(tid);
+            out << "Thread " << tid << ": " << profile.accesses << " accesses, " << profile.misses << " misses, "
+                << profile.invalidations << " invalidations, " << profile.stallCycles << " stall cycles\n";
+        }
+    }
+}
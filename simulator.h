@@ -0,0 +1,225 @@
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include <vector>
+#include <cstdint>
+#include <string>
+#include <iostream>
+#include <memory>
+#include <unordered_map>
+#include "cache.h"
+#include "interconnect.h"
+#include "prefetcher.h"
+#include "heatmap.h"
+#include "tlb.h"
+
+// Simulation configuration (defaults match the L1simulate command line)
+struct SimulationParams
+{
+    std::string baseTraceName;
+    long long int setIndexBits;
+    long long int associativity;
+    long long int blockBits;
+    std::string outFile;
+    long long int numCores;
+    long long int threadsPerCore; // SMT: trace streams sharing each core's L1
+    std::string smtPolicy;        // Thread interleaving: "rr" or "switch" (switch on miss)
+    long long int mshrs;
+    std::string prefetcher;
+    long long int prefetchDegree;
+    long long int prefetchDistance;
+    long long int storeBufferDepth;
+    bool storeBufferTSO;
+    long long int victimEntries; // Fully associative victim cache per core (0 = none)
+    bool wayPrediction;          // MRU way prediction
+    std::string shmName;       // Read accesses from shared-memory rings instead of trace files
+    long long int shmCapacity; // Records per ring
+    std::string interconnect;  // "bus", "ring" or "mesh"
+    long long int meshCols;    // 0 = near-square mesh
+    long long int hopLatency;  // Cycles per router/link hop (ring and mesh)
+    long long int flitBytes;   // Link width (ring and mesh)
+    BusLatencies busLatencies; // Cycles charged per transaction component
+    bool busCostReport;        // Report interconnect cycles by type, source and core
+    long long int pcReportSize; // PCs listed per ranking in the annotation report
+    bool heatMap;              // Per-set counters and hot-block sketches
+    std::string heatMapFile;   // CSV matrix of the per-set counters (empty = report only)
+    long long int heatSampleRate; // Sketches see one in this many events
+    long long int heatTopK;    // Sets and blocks listed in the report
+    long long int warmupAccesses; // Accesses per core applied functionally before timing starts
+    std::string snapshotDir;      // Where warm-up snapshots are cached (empty = always warm up)
+    std::string pageMapping;      // Virtual-to-physical mapping: "identity", "random" or "color"
+    long long int pageBits;       // log2 of the page size (12 = 4 KB, 21 = 2 MB huge pages)
+    long long int tlbEntries;     // Per-core TLB entries (0 = no TLB)
+    long long int tlbAssociativity;
+    long long int tlbMissLatency; // Page walk cycles after a TLB miss
+
+    SimulationParams()
+        : setIndexBits(5),   // Default: 32 sets
+          associativity(2),  // Default: 2-way set associative
+          blockBits(5),      // Default: 32-byte block size
+          numCores(4),
+          threadsPerCore(1),
+          smtPolicy("rr"),
+          mshrs(0),          // Default: blocking caches
+          prefetcher("none"),
+          prefetchDegree(1),
+          prefetchDistance(1),
+          storeBufferDepth(0),
+          storeBufferTSO(false),
+          victimEntries(0),
+          wayPrediction(false),
+          shmCapacity(1 << 16),
+          interconnect("bus"), // Default: central snooping bus
+          meshCols(0),
+          hopLatency(1),
+          flitBytes(16),
+          busLatencies(),
+          busCostReport(false),
+          pcReportSize(10),
+          heatMap(false),
+          heatSampleRate(1),
+          heatTopK(10),
+          warmupAccesses(0),
+          pageMapping("identity"),
+          pageBits(12),
+          tlbEntries(0),
+          tlbAssociativity(4),
+          tlbMissLatency(30)
+    {
+    }
+};
+
+struct TraceEntry
+{
+    bool isWrite;
+    uint64_t address;
+    uint32_t gap; // Non-memory instructions executed before this access
+    int32_t tid;  // Thread ID, -1 if not annotated
+    uint64_t pc;  // 0 if not annotated
+};
+
+// Misses, invalidations and stalls charged to one PC or thread
+struct AccessProfile
+{
+    uint64_t accesses;
+    uint64_t misses;
+    uint64_t invalidations; // Copies in other caches invalidated by these accesses
+    uint64_t stallCycles;   // Cycles spent waiting for the bus (own or another core's transaction)
+};
+
+// Per hardware thread counters (SMT)
+struct ThreadStats
+{
+    uint64_t instructions; // Accesses retired
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t stallCycles;  // Issue slots lost waiting for the bus, an MSHR or the store buffer
+};
+
+// Read a text trace, one access per line: "R 0x..." / "W 0x..." optionally
+// followed by key=value annotations: gap=<n> (non-memory instructions before
+// the access), pc=<hex>, tid=<n>, with gap and tid in decimal. Unknown keys are
+// ignored; a known key whose value is not a number is an error. Compressed traces
+// (tracecodec.h) are recognised by their header. Returns false if the file
+// cannot be opened or is corrupt.
+bool readTraceFile(const std::string &filename, std::vector<TraceEntry> &entries);
+
+// One multi-core system: caches, interconnect and per-core access streams. Accesses can
+// be loaded from trace files or pushed one at a time / in batches, and the
+// system can be advanced cycle by cycle or run to completion. With SMT every
+// core runs threadsPerCore streams over its one cache; stream s is thread
+// s % threadsPerCore of core s / threadsPerCore. Without SMT streams are cores.
+class Simulator
+{
+private:
+    SimulationParams params;
+    long long int numCores;
+    long long int threadsPerCore;
+    long long int numStreams; // numCores * threadsPerCore
+    bool switchOnMiss;        // SMT policy: keep issuing from one thread until it misses or stalls
+    uint64_t globalCycle; // Single global cycle counter
+    std::unique_ptr<Interconnect> bus; // Snooping bus, ring or mesh
+    std::vector<Cache> caches;
+    std::vector<std::unique_ptr<Prefetcher>> prefetchers;
+    std::vector<std::vector<TraceEntry>> traces; // Pending accesses per stream
+    std::vector<size_t> currentInstructionIndex; // Per stream
+    std::vector<uint64_t> totalInstructions;     // Per core
+    std::vector<uint64_t> computeInstructions; // Non-memory instructions from gap annotations, per core
+    std::vector<uint32_t> gapProgress;         // Gap instructions of the current access executed so far, per stream
+    std::vector<size_t> gapDone;               // Index + 1 of the access whose gap has been executed, per stream
+    std::vector<long long int> issueThread;    // Per core: thread to try first this cycle
+    std::vector<long long int> missStream;     // Per core: stream whose blocking miss is on the bus
+    std::vector<ThreadStats> threadStats;      // Per stream
+    std::unique_ptr<PageMapper> pageMapper;    // Null when addresses are used as physical and there is no TLB
+    std::vector<TLB> tlbs;                     // Per core, empty without a TLB
+    std::vector<size_t> translatedIndex;       // Per stream: index + 1 of the access whose translation is done
+    std::vector<uint64_t> physicalAddress;     // Per stream: physical address of that access
+    std::vector<long long int> walkRemaining;  // Per stream: page walk cycles left before the access issues
+    std::unordered_map<uint64_t, AccessProfile> pcProfile;
+    std::unordered_map<int32_t, AccessProfile> threadProfile;
+    std::unique_ptr<HeatMap> heatMap;
+    std::string warmupSource; // How the warm-up state was obtained, for the report
+    std::string error;        // Why the simulation stopped early, empty while it can go on
+
+    bool cycle(); // Simulate one cycle, returns true once every core is done
+    void compact(long long int stream);
+    long long int selectStream(long long int core) const; // Stream that issues this cycle, -1 if all are done
+    void advanceThread(long long int core, long long int stream, bool switchThread);
+    void retire(long long int core, long long int stream);
+    uint64_t warmTranslate(long long int core, uint64_t address); // Maps the page and fills the TLB, no timing
+    void outOfFrames(uint64_t address);                            // Stops the simulation: the page cannot be mapped
+    void profileAccess(const TraceEntry &entry, long long int result, uint64_t misses, uint64_t invalidations);
+    void printProfile(std::ostream &out) const;
+    void printHeatMap(std::ostream &out) const;
+
+public:
+    explicit Simulator(const SimulationParams &params);
+    Simulator(const Simulator &) = delete;
+    Simulator &operator=(const Simulator &) = delete;
+
+    // Input
+    bool loadTraces(const std::string &baseTraceName); // Reads <base>_proc<N>.trace for every stream
+    void pushAccess(long long int stream, bool isWrite, uint64_t address)
+    {
+        if (currentInstructionIndex[stream] >= traces[stream].size())
+        {
+            compact(stream);
+        }
+        TraceEntry entry = {isWrite, address, 0, -1, 0};
+        traces[stream].push_back(entry);
+    }
+    void pushAccesses(long long int stream, const TraceEntry *entries, size_t count);
+    // Apply the first `accesses` queued accesses of every stream to the caches
+    // without timing (MESI states and LRU order only), then start timing from
+    // there with fresh statistics. With a snapshot directory the warmed caches
+    // are loaded from / saved to a snapshot keyed by the warm-up accesses and
+    // the cache geometry. Call before the first step; false on an I/O error.
+    bool warmUp(uint64_t accesses, const std::string &snapshotDir);
+
+    // Execution
+    bool step(uint64_t cycles = 1); // Advance exactly `cycles` cycles, returns true once a cycle found nothing left to do
+    // Run until every queued access has completed, or until the global cycle reaches cycleLimit
+    void run(uint64_t cycleLimit = UINT64_MAX);
+    bool isDone() const; // Also true once the simulation stopped on an error
+    // Empty unless the simulation stopped early; the statistics then cover the cycles simulated so far
+    const std::string &getError() const { return error; }
+
+    // Statistics
+    long long int getNumCores() const { return numCores; }
+    long long int getNumStreams() const { return numStreams; }
+    uint64_t getCycle() const { return globalCycle; }
+    uint64_t getInstructions(long long int core) const { return totalInstructions[core]; }
+    size_t getPendingAccesses(long long int stream) const
+    {
+        return currentInstructionIndex[stream] < traces[stream].size() ? traces[stream].size() - currentInstructionIndex[stream] : 0;
+    }
+    const ThreadStats &getThreadStats(long long int stream) const { return threadStats[stream]; }
+    const CacheStats &getCacheStats(long long int core) const { return caches[core].getStats(); }
+    long long int getPrefetchedLines(long long int core) const { return caches[core].countPrefetchedLines(); }
+    const BusStats &getBusStats() const { return bus->getStats(); }
+    const SimulationParams &getParams() const { return params; }
+    void printReport(std::ostream &out) const;
+    void writeHeatMap(std::ostream &out) const; // sets x (core, event) matrix as CSV
+};
+
+#endif // SIMULATOR_H
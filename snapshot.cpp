@@ -0,0 +1,87 @@
+#include "snapshot.h"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+#include <cstdio>
+
+namespace
+{
+const char snapshotMagic[8] = {'L', '1', 'W', 'A', 'R', 'M', '0', '1'};
+
+template <typename T>
+void put(std::ostream &out, T value)
+{
+    out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+template <typename T>
+bool get(std::istream &in, T &value)
+{
+    return static_cast<bool>(in.read(reinterpret_cast<char *>(&value), sizeof(value)));
+}
+} // namespace
+
+std::string snapshotPath(const std::string &dir, const WarmupSnapshot &key)
+{
+    std::stringstream ss;
+    ss << dir << "/warm-" << std::hex << std::setw(16) << std::setfill('0') << key.traceHash << std::dec
+       << "-s" << key.setIndexBits << "-E" << key.associativity << "-b" << key.blockBits
+       << "-n" << key.numCores << "-w" << key.warmupAccesses << ".snap";
+    return ss.str();
+}
+
+bool readSnapshot(const std::string &path, WarmupSnapshot &snapshot)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open())
+        return false;
+
+    char magic[sizeof(snapshotMagic)];
+    if (!in.read(magic, sizeof(magic)) || memcmp(magic, snapshotMagic, sizeof(magic)) != 0)
+        return false;
+    if (!get(in, snapshot.setIndexBits) || !get(in, snapshot.associativity) || !get(in, snapshot.blockBits) ||
+        !get(in, snapshot.numCores) || !get(in, snapshot.warmupAccesses) || !get(in, snapshot.traceHash))
+        return false;
+    if (snapshot.setIndexBits > 30 || snapshot.associativity == 0 || snapshot.associativity > 65536 ||
+        snapshot.numCores == 0 || snapshot.numCores > 65536)
+        return false;
+
+    uint64_t count = static_cast<uint64_t>(snapshot.numCores) * snapshot.associativity << snapshot.setIndexBits;
+    snapshot.lines.resize(count);
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        SnapshotLine &line = snapshot.lines[i];
+        if (!get(in, line.tag) || !get(in, line.state) || !get(in, line.dirty) || !get(in, line.age))
+            return false;
+    }
+    return true;
+}
+
+bool writeSnapshot(const std::string &path, const WarmupSnapshot &snapshot)
+{
+    // Write to a temporary name first so a concurrent sweep run never reads a partial file
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open())
+            return false;
+        out.write(snapshotMagic, sizeof(snapshotMagic));
+        put(out, snapshot.setIndexBits);
+        put(out, snapshot.associativity);
+        put(out, snapshot.blockBits);
+        put(out, snapshot.numCores);
+        put(out, snapshot.warmupAccesses);
+        put(out, snapshot.traceHash);
+        for (const SnapshotLine &line : snapshot.lines)
+        {
+            put(out, line.tag);
+            put(out, line.state);
+            put(out, line.dirty);
+            put(out, line.age);
+        }
+        if (!out)
+            return false;
+    }
+    return std::rename(tmpPath.c_str(), path.c_str()) == 0;
+}
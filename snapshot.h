@@ -0,0 +1,45 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <vector>
+#include <cstdint>
+#include <string>
+
+// One cache line of a warm-up snapshot. Tags are stored in full so a snapshot
+// does not depend on how a cache packs them.
+struct SnapshotLine
+{
+    uint64_t tag;
+    uint8_t state; // CacheState
+    uint8_t dirty;
+    uint32_t age;  // LRU rank within the set, 0 = least recently used
+};
+
+// Cache contents of every core after a functional warm-up of the first
+// `warmupAccesses` accesses of each core. Only usable by runs with the same
+// geometry, core count and warm-up region (traceHash).
+struct WarmupSnapshot
+{
+    uint32_t setIndexBits;
+    uint32_t associativity;
+    uint32_t blockBits;
+    uint32_t numCores;
+    uint64_t warmupAccesses;
+    uint64_t traceHash;              // Hash of the accesses in the warm-up region of every core
+    std::vector<SnapshotLine> lines; // Core, then set, then way
+
+    bool sameKey(const WarmupSnapshot &other) const
+    {
+        return setIndexBits == other.setIndexBits && associativity == other.associativity &&
+               blockBits == other.blockBits && numCores == other.numCores &&
+               warmupAccesses == other.warmupAccesses && traceHash == other.traceHash;
+    }
+};
+
+// <dir>/warm-<hash>-s<s>-E<E>-b<b>-n<cores>-w<accesses>.snap
+std::string snapshotPath(const std::string &dir, const WarmupSnapshot &key);
+// False if the file does not exist or is not a valid snapshot
+bool readSnapshot(const std::string &path, WarmupSnapshot &snapshot);
+bool writeSnapshot(const std::string &path, const WarmupSnapshot &snapshot);
+
+#endif // SNAPSHOT_H
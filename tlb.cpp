@@ -0,0 +1,113 @@
+#include "tlb.h"
+
+const uint32_t PageMapper::physicalAddressBits;
+
+bool isKnownPageMapping(const std::string &name)
+{
+    return name == "identity" || name == "random" || name == "color";
+}
+
+PageMapper::Policy pageMappingPolicy(const std::string &name)
+{
+    if (name == "random")
+        return PageMapper::Policy::Random;
+    if (name == "color")
+        return PageMapper::Policy::Coloring;
+    return PageMapper::Policy::Identity;
+}
+
+PageMapper::PageMapper(Policy policy, uint32_t pageBits, uint32_t colorBits)
+    : policy(policy), pageBits(pageBits), colorBits(colorBits),
+      frameMask((1ULL << (physicalAddressBits - pageBits)) - 1), rngState(0x2545f4914f6cdd1dULL), pageTable(),
+      usedFrames(), colorFrames()
+{
+    if (this->colorBits > physicalAddressBits - pageBits)
+        this->colorBits = physicalAddressBits - pageBits;
+}
+
+bool PageMapper::allocateFrame(uint64_t page, uint64_t &frame)
+{
+    uint64_t colorMask = (1ULL << colorBits) - 1;
+    if (policy == Policy::Coloring)
+    {
+        uint64_t &used = colorFrames[page & colorMask];
+        if (used > (frameMask >> colorBits))
+            return false;
+        used++;
+    }
+    else if (usedFrames.size() > frameMask)
+    {
+        return false;
+    }
+    while (true)
+    {
+        uint64_t z = (rngState += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        frame = (z ^ (z >> 31)) & frameMask;
+        if (policy == Policy::Coloring)
+        {
+            frame = (frame & ~colorMask) | (page & colorMask);
+        }
+        // A free frame is left (checked above), and touched pages are usually
+        // far fewer than frames, so retries are rare
+        if (usedFrames.insert(frame).second)
+            return true;
+    }
+}
+
+bool PageMapper::translate(uint64_t virtualAddress, uint64_t &physicalAddress)
+{
+    if (policy == Policy::Identity)
+    {
+        physicalAddress = virtualAddress;
+        return true;
+    }
+
+    uint64_t page = virtualAddress >> pageBits;
+    std::unordered_map<uint64_t, uint64_t>::iterator it = pageTable.find(page);
+    uint64_t frame;
+    if (it != pageTable.end())
+    {
+        frame = it->second;
+    }
+    else
+    {
+        if (!allocateFrame(page, frame))
+            return false;
+        pageTable[page] = frame;
+    }
+    physicalAddress = (frame << pageBits) | (virtualAddress & ((1ULL << pageBits) - 1));
+    return true;
+}
+
+TLB::TLB(uint32_t entries, uint32_t associativity)
+    : numSets(entries / associativity), associativity(associativity), pages(entries, 0), lastAccess(entries, 0),
+      clock(0), stats()
+{
+}
+
+bool TLB::lookup(uint64_t page)
+{
+    uint32_t set = static_cast<uint32_t>(page % numSets);
+    size_t base = static_cast<size_t>(set) * associativity;
+    size_t victim = base;
+    ++clock;
+    for (size_t i = base; i < base + associativity; ++i)
+    {
+        if (lastAccess[i] != 0 && pages[i] == page)
+        {
+            lastAccess[i] = clock;
+            stats.hits++;
+            return true;
+        }
+        if (lastAccess[i] < lastAccess[victim])
+        {
+            victim = i;
+        }
+    }
+    stats.misses++;
+    pages[victim] = page;
+    lastAccess[victim] = clock;
+    return false;
+}
@@ -0,0 +1,76 @@
+#ifndef TLB_H
+#define TLB_H
+
+#include <vector>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+// Virtual-to-physical page mapping shared by all cores (one address space).
+// Pages are mapped on first touch:
+//   identity  physical = virtual
+//   random    a random free frame, so page colors are scrambled
+//   color     a random free frame of the same color as the virtual page, where
+//             the color is the part of the set index above the page offset
+// Frames are never shared, so a workload touching more pages than the physical
+// memory (or a color) has frames cannot be mapped and translate() fails.
+class PageMapper
+{
+public:
+    enum class Policy
+    {
+        Identity,
+        Random,
+        Coloring,
+    };
+    static const uint32_t physicalAddressBits = 40;
+
+private:
+    Policy policy;
+    uint32_t pageBits;
+    uint32_t colorBits;
+    uint64_t frameMask;                               // Frames of the simulated physical memory
+    uint64_t rngState;                                // SplitMix64, fixed seed so runs are reproducible
+    std::unordered_map<uint64_t, uint64_t> pageTable; // Virtual page -> physical frame
+    std::unordered_set<uint64_t> usedFrames;
+    std::unordered_map<uint64_t, uint64_t> colorFrames; // Color -> frames of that color in use
+
+    bool allocateFrame(uint64_t page, uint64_t &frame); // false once no frame is left for the page
+
+public:
+    // colorBits: set index bits above the page offset (setIndexBits + blockBits - pageBits, at least 0)
+    PageMapper(Policy policy, uint32_t pageBits, uint32_t colorBits);
+    // false if the page is unmapped and every frame it could use is taken
+    bool translate(uint64_t virtualAddress, uint64_t &physicalAddress);
+    size_t getMappedPages() const { return pageTable.size(); }
+};
+
+bool isKnownPageMapping(const std::string &name);
+PageMapper::Policy pageMappingPolicy(const std::string &name);
+
+struct TLBStats
+{
+    long long int hits;
+    long long int misses;
+    long long int walkCycles; // Cycles spent walking the page table after misses
+};
+
+// Set-associative TLB with LRU replacement, one per core
+class TLB
+{
+private:
+    uint32_t numSets;
+    uint32_t associativity;
+    std::vector<uint64_t> pages;      // Virtual page of each entry, numSets x associativity
+    std::vector<uint64_t> lastAccess; // LRU stamps, 0 = invalid
+    uint64_t clock;
+
+public:
+    TLBStats stats;
+    TLB(uint32_t entries, uint32_t associativity);
+    bool lookup(uint64_t page); // true on a hit; a miss installs the page in the LRU entry
+    void resetStats() { stats = TLBStats(); }
+};
+
+#endif // TLB_H
@@ -0,0 +1,240 @@
+#include "tracecodec.h"
+#include <cstring>
+#include <algorithm>
+
+namespace
+{
+const char traceMagic[4] = {'L', '1', 'T', 'Z'};
+const uint8_t traceVersion = 1;
+const int maxPeriod = 16;
+
+// Tag byte bits
+const uint8_t tagRepeat = 0x80;
+const uint8_t tagWrite = 0x01;
+const uint8_t tagGap = 0x02;
+const uint8_t tagPc = 0x04;
+const uint8_t tagTid = 0x08;
+
+// What a repeat token copies from an earlier access
+struct Shape
+{
+    bool isWrite;
+    uint64_t addressDelta;
+    uint64_t pcDelta;
+    uint32_t gap;
+    int32_t tid;
+
+    bool operator==(const Shape &other) const
+    {
+        return isWrite == other.isWrite && addressDelta == other.addressDelta && pcDelta == other.pcDelta &&
+               gap == other.gap && tid == other.tid;
+    }
+};
+
+uint64_t zigzag(uint64_t delta)
+{
+    return (delta << 1) ^ static_cast<uint64_t>(static_cast<int64_t>(delta) >> 63);
+}
+
+uint64_t unzigzag(uint64_t value)
+{
+    return (value >> 1) ^ (~(value & 1) + 1);
+}
+
+void putVarint(std::string &out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+size_t varintSize(uint64_t value)
+{
+    size_t size = 1;
+    while (value >= 0x80)
+    {
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
+
+bool getVarint(const uint8_t *&p, const uint8_t *end, uint64_t &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7)
+    {
+        uint8_t byte = *p++;
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+size_t literalSize(const Shape &shape, int32_t prevTid)
+{
+    size_t size = 1 + varintSize(zigzag(shape.addressDelta));
+    if (shape.gap != 0)
+        size += varintSize(shape.gap);
+    if (shape.pcDelta != 0)
+        size += varintSize(zigzag(shape.pcDelta));
+    if (shape.tid != prevTid)
+        size += varintSize(zigzag(static_cast<uint64_t>(static_cast<int64_t>(shape.tid))));
+    return size;
+}
+} // namespace
+
+bool isCompressedTrace(const char *data, size_t size)
+{
+    return size >= sizeof(traceMagic) && memcmp(data, traceMagic, sizeof(traceMagic)) == 0;
+}
+
+void encodeTrace(const std::vector<TraceEntry> &entries, std::string &out)
+{
+    out.append(traceMagic, sizeof(traceMagic));
+    out.push_back(static_cast<char>(traceVersion));
+    putVarint(out, entries.size());
+
+    std::vector<Shape> shapes(entries.size());
+    uint64_t prevAddress = 0, prevPc = 0;
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        const TraceEntry &entry = entries[i];
+        Shape shape = {entry.isWrite, entry.address - prevAddress, entry.pc - prevPc, entry.gap, entry.tid};
+        shapes[i] = shape;
+        prevAddress = entry.address;
+        prevPc = entry.pc;
+    }
+
+    int32_t prevTid = -1;
+    size_t i = 0;
+    while (i < shapes.size())
+    {
+        // Longest run that repeats the access k back, for every period k
+        size_t bestRun = 0;
+        size_t bestPeriod = 0;
+        for (size_t k = 1; k <= static_cast<size_t>(maxPeriod) && k <= i; ++k)
+        {
+            size_t run = 0;
+            while (i + run < shapes.size() && shapes[i + run] == shapes[i + run - k])
+                run++;
+            if (run > bestRun)
+            {
+                bestRun = run;
+                bestPeriod = k;
+            }
+        }
+
+        const Shape &shape = shapes[i];
+        if (bestRun > 0 && 1 + varintSize(bestRun) <= literalSize(shape, prevTid))
+        {
+            out.push_back(static_cast<char>(tagRepeat | (bestPeriod - 1)));
+            putVarint(out, bestRun);
+            prevTid = shapes[i + bestRun - 1].tid;
+            i += bestRun;
+            continue;
+        }
+
+        uint8_t tag = 0;
+        tag |= shape.isWrite ? tagWrite : 0;
+        tag |= shape.gap != 0 ? tagGap : 0;
+        tag |= shape.pcDelta != 0 ? tagPc : 0;
+        tag |= shape.tid != prevTid ? tagTid : 0;
+        out.push_back(static_cast<char>(tag));
+        putVarint(out, zigzag(shape.addressDelta));
+        if (tag & tagGap)
+            putVarint(out, shape.gap);
+        if (tag & tagPc)
+            putVarint(out, zigzag(shape.pcDelta));
+        if (tag & tagTid)
+            putVarint(out, zigzag(static_cast<uint64_t>(static_cast<int64_t>(shape.tid))));
+        prevTid = shape.tid;
+        i++;
+    }
+}
+
+bool decodeTrace(const char *data, size_t size, std::vector<TraceEntry> &entries)
+{
+    const uint8_t *p = reinterpret_cast<const uint8_t *>(data);
+    const uint8_t *end = p + size;
+    if (!isCompressedTrace(data, size) || size < sizeof(traceMagic) + 1 || p[sizeof(traceMagic)] != traceVersion)
+        return false;
+    p += sizeof(traceMagic) + 1;
+
+    uint64_t count;
+    if (!getVarint(p, end, count))
+        return false;
+    size_t base = entries.size();
+    // Repeat tokens make the count independent of the file size, so only the
+    // reservation is capped against a corrupt header
+    entries.reserve(base + static_cast<size_t>(std::min<uint64_t>(count, 1 << 24)));
+
+    Shape history[maxPeriod]; // Shapes of the last maxPeriod accesses, by index % maxPeriod
+    uint64_t address = 0, pc = 0;
+    int32_t tid = -1;
+    uint64_t decoded = 0;
+    while (decoded < count)
+    {
+        if (p >= end)
+            return false;
+        uint8_t tag = *p++;
+        uint64_t run = 1;
+        Shape shape;
+        size_t period = 0;
+        if (tag & tagRepeat)
+        {
+            period = (tag & 0x0f) + 1;
+            if (!getVarint(p, end, run) || run == 0 || period > decoded || run > count - decoded)
+                return false;
+        }
+        else
+        {
+            uint64_t value;
+            shape.isWrite = (tag & tagWrite) != 0;
+            shape.gap = 0;
+            shape.pcDelta = 0;
+            shape.tid = tid;
+            if (!getVarint(p, end, value))
+                return false;
+            shape.addressDelta = unzigzag(value);
+            if (tag & tagGap)
+            {
+                if (!getVarint(p, end, value))
+                    return false;
+                shape.gap = static_cast<uint32_t>(value);
+            }
+            if (tag & tagPc)
+            {
+                if (!getVarint(p, end, value))
+                    return false;
+                shape.pcDelta = unzigzag(value);
+            }
+            if (tag & tagTid)
+            {
+                if (!getVarint(p, end, value))
+                    return false;
+                shape.tid = static_cast<int32_t>(static_cast<int64_t>(unzigzag(value)));
+            }
+        }
+
+        for (uint64_t r = 0; r < run; ++r)
+        {
+            if (period > 0)
+            {
+                shape = history[(decoded - period) % maxPeriod];
+            }
+            history[decoded % maxPeriod] = shape;
+            address += shape.addressDelta;
+            pc += shape.pcDelta;
+            tid = shape.tid;
+            TraceEntry entry = {shape.isWrite, address, shape.gap, tid, pc};
+            entries.push_back(entry);
+            decoded++;
+        }
+    }
+    return p == end;
+}
@@ -0,0 +1,29 @@
+#ifndef TRACECODEC_H
+#define TRACECODEC_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "simulator.h"
+
+// Compressed trace format. A file starts with "L1TZ", a version byte and the
+// number of accesses (varint), followed by tokens:
+//
+//   literal  0000tpgw   one access. Flags: w write, g gap present, p pc changed,
+//                       t tid changed; then the address delta (zigzag varint)
+//                       and the flagged fields (gap varint, pc delta zigzag,
+//                       tid zigzag)
+//   repeat   1000kkkk   n accesses (varint) that each repeat the access k+1
+//                       back (period 1..16): same address/pc deltas, type,
+//                       gap and tid
+//
+// Addresses and PCs are delta coded from the previous access of the same file
+// (one file per core), so strided loops become a literal or two followed by a
+// single repeat token.
+
+bool isCompressedTrace(const char *data, size_t size);
+void encodeTrace(const std::vector<TraceEntry> &entries, std::string &out);
+// Appends the decoded accesses; false if the data is truncated or corrupt
+bool decodeTrace(const char *data, size_t size, std::vector<TraceEntry> &entries);
+
+#endif // TRACECODEC_H
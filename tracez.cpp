@@ -0,0 +1,102 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdio>
+#include "simulator.h"
+#include "tracecodec.h"
+
+// Converts traces between the text format and the compressed format read by L1simulate
+
+void printUsage()
+{
+    std::cout << "Usage: ./L1tracez [options] <input> <output>\n"
+              << "Compresses a text trace (R/W 0x... lines). Compressed traces can be passed\n"
+              << "to L1simulate directly, as <app>_proc<N>.trace or <app>_proc<N>.tracez.\n"
+              << "Options:\n"
+              << "  -d              : expand a compressed trace back to text\n"
+              << "  -h              : print this help\n";
+}
+
+static bool writeText(const std::string &filename, const std::vector<TraceEntry> &entries)
+{
+    FILE *out = fopen(filename.c_str(), "w");
+    if (!out)
+        return false;
+    for (const TraceEntry &entry : entries)
+    {
+        fprintf(out, "%c 0x%llx", entry.isWrite ? 'W' : 'R', static_cast<unsigned long long>(entry.address));
+        if (entry.gap != 0)
+            fprintf(out, " gap=%u", entry.gap);
+        if (entry.pc != 0)
+            fprintf(out, " pc=%llx", static_cast<unsigned long long>(entry.pc));
+        if (entry.tid >= 0)
+            fprintf(out, " tid=%d", entry.tid);
+        fputc('\n', out);
+    }
+    return fclose(out) == 0;
+}
+
+int main(int argc, char *argv[])
+{
+    bool expand = false;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-d") == 0)
+        {
+            expand = true;
+        }
+        else if (strcmp(argv[i], "-h") == 0)
+        {
+            printUsage();
+            return 0;
+        }
+        else
+        {
+            files.push_back(argv[i]);
+        }
+    }
+    if (files.size() != 2)
+    {
+        printUsage();
+        return 1;
+    }
+
+    // readTraceFile accepts both formats
+    std::vector<TraceEntry> entries;
+    if (!readTraceFile(files[0], entries))
+    {
+        return 1;
+    }
+
+    if (expand)
+    {
+        if (!writeText(files[1], entries))
+        {
+            std::cerr << "Error: Could not write " << files[1] << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    std::string data;
+    encodeTrace(entries, data);
+    std::ofstream out(files[1], std::ios::binary | std::ios::trunc);
+    if (!out.is_open() || !out.write(data.data(), data.size()))
+    {
+        std::cerr << "Error: Could not write " << files[1] << std::endl;
+        return 1;
+    }
+
+    std::ifstream in(files[0], std::ios::binary | std::ios::ate);
+    long long int inSize = in.is_open() ? static_cast<long long int>(in.tellg()) : 0;
+    std::cout << files[0] << ": " << entries.size() << " accesses, " << inSize << " -> " << data.size() << " bytes";
+    if (!data.empty() && inSize > 0)
+    {
+        std::cout << " (" << static_cast<double>(inSize) / data.size() << "x)";
+    }
+    std::cout << "\n";
+    return 0;
+}
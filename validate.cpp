@@ -0,0 +1,614 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+#include <iomanip>
+#include <algorithm>
+#include "simulator.h"
+#include "tracecodec.h"
+
+// Differential validation of simulation engines. Every engine has to reproduce
+// the reference loop of L1simulate (all traces loaded, then Simulator::run)
+// exactly: the same per-core CacheStats, BusStats, retired accesses and final
+// global cycle. A new engine is added to the engines table below. As all
+// engines drive the same Simulator::cycle, a model bug would be reproduced by
+// every one of them, so each run is also checked against invariants that hold
+// for any correct simulation.
+
+struct Workload
+{
+    SimulationParams params;
+    std::vector<std::vector<TraceEntry>> streams; // One per hardware thread (numCores * threadsPerCore)
+    std::string label;
+};
+
+// Runs the workload on a fresh simulator and stops once the global cycle reaches
+// cycleLimit. Returns false, with the reason in error, if it could not feed the workload.
+typedef bool (*EngineRun)(Simulator &sim, const Workload &workload, uint64_t cycleLimit, std::string &error);
+
+struct Engine
+{
+    const char *name;
+    const char *description;
+    EngineRun run;
+};
+
+static void pushAll(Simulator &sim, const Workload &workload)
+{
+    for (size_t stream = 0; stream < workload.streams.size(); ++stream)
+    {
+        sim.pushAccesses(stream, workload.streams[stream].data(), workload.streams[stream].size());
+    }
+}
+
+static bool runReference(Simulator &sim, const Workload &workload, uint64_t cycleLimit, std::string &)
+{
+    pushAll(sim, workload);
+    sim.run(cycleLimit);
+    return true;
+}
+
+// One cycle at a time until step() reports completion, as the library API is driven
+static bool runStepped(Simulator &sim, const Workload &workload, uint64_t cycleLimit, std::string &)
+{
+    pushAll(sim, workload);
+    while (sim.getCycle() < cycleLimit && !sim.step(1))
+    {
+    }
+    return true;
+}
+
+// Small batches pushed while the simulation runs, as simulateFromRings does with --shm
+static bool runStreamed(Simulator &sim, const Workload &workload, uint64_t cycleLimit, std::string &)
+{
+    const size_t lookahead = 2;
+    const size_t batchSize = 5; // Small, so the queues are compacted often
+    std::vector<size_t> fed(workload.streams.size(), 0);
+    while (sim.getCycle() < cycleLimit)
+    {
+        bool open = false;
+        for (size_t stream = 0; stream < workload.streams.size(); ++stream)
+        {
+            size_t count = std::min(batchSize, workload.streams[stream].size() - fed[stream]);
+            if (count > 0)
+            {
+                sim.pushAccesses(stream, &workload.streams[stream][fed[stream]], count);
+                fed[stream] += count;
+            }
+            open |= fed[stream] < workload.streams[stream].size();
+        }
+        if (!open)
+            break;
+
+        bool low = false;
+        while (!low && sim.getCycle() < cycleLimit)
+        {
+            sim.step(1);
+            for (size_t stream = 0; stream < workload.streams.size() && !low; ++stream)
+            {
+                low = fed[stream] < workload.streams[stream].size() && sim.getPendingAccesses(stream) < lookahead;
+            }
+        }
+    }
+    sim.run(cycleLimit);
+    return true;
+}
+
+// Traces round-tripped through the compressed format
+static bool runCompressed(Simulator &sim, const Workload &workload, uint64_t cycleLimit, std::string &error)
+{
+    for (size_t stream = 0; stream < workload.streams.size(); ++stream)
+    {
+        std::string data;
+        std::vector<TraceEntry> decoded;
+        encodeTrace(workload.streams[stream], data);
+        if (!decodeTrace(data.data(), data.size(), decoded))
+        {
+            error = "trace " + std::to_string(stream) + " does not decode";
+            return false;
+        }
+        sim.pushAccesses(stream, decoded.data(), decoded.size());
+    }
+    sim.run(cycleLimit);
+    return true;
+}
+
+static const Engine engines[] = {
+    {"reference", "all traces loaded, Simulator::run (L1simulate)", runReference},
+    {"stepped", "Simulator::step(1) until done (library API)", runStepped},
+    {"streamed", "accesses pushed in small batches while running (--shm)", runStreamed},
+    {"compressed", "traces round-tripped through the compressed format", runCompressed},
+};
+static const size_t engineCount = sizeof(engines) / sizeof(engines[0]);
+
+// Everything an engine must reproduce
+struct Observation
+{
+    uint64_t cycle;
+    std::vector<CacheStats> caches;
+    std::vector<uint64_t> instructions;
+    std::vector<uint64_t> streamInstructions; // Retired accesses of each trace
+    std::vector<long long int> prefetchedLines; // Per core: prefetched lines still unused at the end
+    BusStats bus;
+    double seconds;
+    std::string error; // Why the engine could not run the workload, empty if it did
+};
+
+struct CacheField
+{
+    const char *name;
+    long long int CacheStats::*member;
+};
+
+#define CACHE_FIELD(f) {#f, &CacheStats::f}
+static const CacheField cacheFields[] = {
+    CACHE_FIELD(readCount), CACHE_FIELD(writeCount), CACHE_FIELD(hitCount), CACHE_FIELD(missCount),
+    CACHE_FIELD(evictionCount), CACHE_FIELD(writebackCount), CACHE_FIELD(invalidationCount),
+    CACHE_FIELD(busTrafficBytes), CACHE_FIELD(execCycles), CACHE_FIELD(idleCycles), CACHE_FIELD(totalCycles),
+    CACHE_FIELD(mshrMergedMisses), CACHE_FIELD(mshrStallCycles), CACHE_FIELD(mshrOccupancySum),
+    CACHE_FIELD(mshrOccupancyPeak), CACHE_FIELD(mshrSampledCycles), CACHE_FIELD(prefetchIssued),
+    CACHE_FIELD(prefetchUseful), CACHE_FIELD(prefetchLate), CACHE_FIELD(prefetchUnused),
+    CACHE_FIELD(prefetchInvalidations), CACHE_FIELD(sbCoalesced), CACHE_FIELD(sbForwarded),
+    CACHE_FIELD(sbStallCycles), CACHE_FIELD(sbDrained), CACHE_FIELD(sbOccupancyPeak), CACHE_FIELD(victimHits),
+    CACHE_FIELD(victimEvictions), CACHE_FIELD(wayPredLookups), CACHE_FIELD(wayPredHits), CACHE_FIELD(tagChecks),
+};
+#undef CACHE_FIELD
+// A counter added to CacheStats must be added above as well
+static_assert(sizeof(CacheStats) == sizeof(cacheFields) / sizeof(cacheFields[0]) * sizeof(long long int),
+              "cacheFields does not cover CacheStats");
+static_assert(sizeof(BusStats) == (7 + 2 * busCycleSourceCount + busTransactionTypeCount) * sizeof(uint64_t),
+              "busValues does not cover BusStats");
+
+static void busValues(const BusStats &bus, std::vector<std::pair<std::string, uint64_t>> &values)
+{
+    const char *typeNames[busTransactionTypeCount] = {"BusRd", "BusRdX", "BusUpgr"};
+    values.push_back(std::make_pair("totalTransactions", bus.totalTransactions));
+    values.push_back(std::make_pair("busRdTransactions", bus.busRdTransactions));
+    values.push_back(std::make_pair("busRdXTransactions", bus.busRdXTransactions));
+    values.push_back(std::make_pair("busUpgrTransactions", bus.busUpgrTransactions));
+    values.push_back(std::make_pair("totalBusTraffic", bus.totalBusTraffic));
+    values.push_back(std::make_pair("elapsedCycles", bus.elapsedCycles));
+    values.push_back(std::make_pair("busyCycles", bus.busyCycles));
+    for (int i = 0; i < busCycleSourceCount; ++i)
+    {
+        std::string source = busCycleSourceName(static_cast<BusCycleSource>(i));
+        values.push_back(std::make_pair("sourceCycles[" + source + "]", bus.sourceCycles[i]));
+        values.push_back(std::make_pair("sourceCharges[" + source + "]", bus.sourceCharges[i]));
+    }
+    for (int i = 0; i < busTransactionTypeCount; ++i)
+    {
+        values.push_back(std::make_pair(std::string("typeBusyCycles[") + typeNames[i] + "]", bus.typeBusyCycles[i]));
+    }
+}
+
+static Observation observe(const Engine &engine, const Workload &workload, uint64_t cycleLimit)
+{
+    Simulator sim(workload.params);
+    Observation observation;
+    auto start = std::chrono::steady_clock::now();
+    if (!engine.run(sim, workload, cycleLimit, observation.error) && observation.error.empty())
+        observation.error = "engine failed";
+    if (observation.error.empty())
+        observation.error = sim.getError();
+    observation.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    observation.cycle = sim.getCycle();
+    for (long long int core = 0; core < sim.getNumCores(); ++core)
+    {
+        observation.caches.push_back(sim.getCacheStats(core));
+        observation.instructions.push_back(sim.getInstructions(core));
+        observation.prefetchedLines.push_back(sim.getPrefetchedLines(core));
+    }
+    for (long long int stream = 0; stream < sim.getNumStreams(); ++stream)
+    {
+        observation.streamInstructions.push_back(sim.getThreadStats(stream).instructions);
+    }
+    observation.bus = sim.getBusStats();
+    return observation;
+}
+
+// Every counter that differs, as "name: expected vs actual"
+static std::vector<std::string> compare(const Observation &expected, const Observation &actual)
+{
+    std::vector<std::string> differences;
+    auto note = [&differences](const std::string &name, long long int a, long long int b)
+    {
+        if (a != b)
+            differences.push_back(name + ": " + std::to_string(a) + " vs " + std::to_string(b));
+    };
+    note("global cycle", expected.cycle, actual.cycle);
+    for (size_t core = 0; core < expected.caches.size(); ++core)
+    {
+        std::string prefix = "core " + std::to_string(core) + " ";
+        note(prefix + "instructions", expected.instructions[core], actual.instructions[core]);
+        for (const CacheField &field : cacheFields)
+        {
+            note(prefix + field.name, expected.caches[core].*field.member, actual.caches[core].*field.member);
+        }
+    }
+    std::vector<std::pair<std::string, uint64_t>> expectedBus, actualBus;
+    busValues(expected.bus, expectedBus);
+    busValues(actual.bus, actualBus);
+    for (size_t i = 0; i < expectedBus.size(); ++i)
+    {
+        note("bus " + expectedBus[i].first, expectedBus[i].second, actualBus[i].second);
+    }
+    return differences;
+}
+
+// Properties of any correct complete run, independent of the engine: every
+// trace entry retires exactly once and the cache counts every access once
+static std::vector<std::string> checkInvariants(const Workload &workload, const Observation &observation)
+{
+    std::vector<std::string> violations;
+    auto require = [&violations](bool holds, const std::string &what)
+    {
+        if (!holds)
+            violations.push_back(what);
+    };
+    long long int threads = workload.params.threadsPerCore;
+    for (size_t stream = 0; stream < workload.streams.size(); ++stream)
+    {
+        require(observation.streamInstructions[stream] == workload.streams[stream].size(),
+                "trace " + std::to_string(stream) + " retired " + std::to_string(observation.streamInstructions[stream]) +
+                    " of " + std::to_string(workload.streams[stream].size()) + " accesses");
+    }
+    for (size_t core = 0; core < observation.caches.size(); ++core)
+    {
+        const CacheStats &cs = observation.caches[core];
+        std::string prefix = "core " + std::to_string(core) + " ";
+        long long int accesses = cs.readCount + cs.writeCount;
+        uint64_t streamSum = 0;
+        for (long long int thread = 0; thread < threads; ++thread)
+            streamSum += observation.streamInstructions[core * threads + thread];
+        require(observation.instructions[core] == streamSum,
+                prefix + "instructions " + std::to_string(observation.instructions[core]) + " != retired accesses of its traces " +
+                    std::to_string(streamSum));
+        require(static_cast<long long int>(observation.instructions[core]) == accesses,
+                prefix + "instructions " + std::to_string(observation.instructions[core]) + " != reads + writes " +
+                    std::to_string(accesses));
+        long long int counted = cs.hitCount + cs.missCount + cs.sbCoalesced + cs.sbForwarded;
+        require(counted == accesses, prefix + "hits + misses + coalesced + forwarded " + std::to_string(counted) +
+                                         " != reads + writes " + std::to_string(accesses));
+        if (workload.params.storeBufferDepth > 0)
+        {
+            require(cs.sbDrained + cs.sbCoalesced == cs.writeCount,
+                    prefix + "drained + coalesced stores " + std::to_string(cs.sbDrained + cs.sbCoalesced) +
+                        " != writes " + std::to_string(cs.writeCount));
+        }
+        // Every prefetch ends up used, unused (evicted or invalidated) or still resident
+        long long int accounted = cs.prefetchUseful + cs.prefetchUnused + observation.prefetchedLines[core];
+        require(accounted == cs.prefetchIssued, prefix + "useful + unused + resident prefetches " +
+                                                    std::to_string(accounted) + " != issued " +
+                                                    std::to_string(cs.prefetchIssued));
+    }
+    return violations;
+}
+
+// Prints a failed check of one engine on one case, at most 10 lines of detail
+static void printFailure(const char *kind, const Engine &engine, size_t index, const Workload &workload,
+                         const std::string &summary, const std::vector<std::string> &details)
+{
+    std::cout << kind << " " << engine.name << " on case " << index << " (" << workload.label << "): " << summary << "\n";
+    for (size_t i = 0; i < details.size() && i < 10; ++i)
+        std::cout << "  " << details[i] << "\n";
+    if (details.size() > 10)
+        std::cout << "  ... " << details.size() - 10 << " more\n";
+}
+
+// First cycle limit at which the engine and the reference disagree. Every probe
+// reruns both from scratch; with no cycle simulated they always agree.
+static uint64_t bisect(const Engine &engine, const Workload &workload, uint64_t high)
+{
+    uint64_t low = 0;
+    while (high - low > 1)
+    {
+        uint64_t mid = low + (high - low) / 2;
+        if (compare(observe(engines[0], workload, mid), observe(engine, workload, mid)).empty())
+        {
+            low = mid;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    return high;
+}
+
+// SplitMix64: the same cases on every platform and standard library
+struct CaseRandom
+{
+    uint64_t state;
+
+    uint64_t next()
+    {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+    uint64_t below(uint64_t n) { return next() % n; }
+};
+
+static Workload syntheticCase(uint64_t seed, long long int index, long long int accesses, bool plain)
+{
+    CaseRandom random = {seed * 0x100000001b3ULL + static_cast<uint64_t>(index)};
+    Workload workload;
+    SimulationParams &params = workload.params;
+    params.setIndexBits = random.below(7);
+    params.associativity = 1LL << random.below(4);
+    params.blockBits = 2 + random.below(5);
+    params.numCores = 1 + random.below(4);
+    workload.label = "-s " + std::to_string(params.setIndexBits) + " -E " + std::to_string(params.associativity) +
+                     " -b " + std::to_string(params.blockBits) + " -n " + std::to_string(params.numCores);
+    if (!plain)
+    {
+        const char *prefetchers[] = {"none", "none", "nextline", "stride", "stream"};
+        const char *interconnects[] = {"bus", "bus", "ring", "mesh"};
+        const char *pageMappings[] = {"identity", "identity", "random", "color"};
+        params.mshrs = random.below(2) ? 0 : 2 * (1 + random.below(2));
+        params.storeBufferDepth = random.below(3) ? 0 : 4;
+        params.storeBufferTSO = random.below(2) != 0;
+        params.prefetcher = prefetchers[random.below(5)];
+        params.victimEntries = random.below(3) ? 0 : 4;
+        params.wayPrediction = random.below(2) != 0;
+        params.interconnect = interconnects[random.below(4)];
+        params.threadsPerCore = random.below(3) ? 1 : 2;
+        params.smtPolicy = random.below(2) ? "rr" : "switch";
+        params.pageMapping = pageMappings[random.below(4)];
+        params.tlbEntries = random.below(2) ? 0 : 8;
+        if (params.mshrs > 0)
+            workload.label += " --mshrs " + std::to_string(params.mshrs);
+        if (params.storeBufferDepth > 0)
+            workload.label += " --sb " + std::to_string(params.storeBufferDepth) + (params.storeBufferTSO ? " --sb-tso" : "");
+        if (params.prefetcher != "none")
+            workload.label += " --prefetch " + params.prefetcher;
+        if (params.victimEntries > 0)
+            workload.label += " --victim " + std::to_string(params.victimEntries);
+        if (params.wayPrediction)
+            workload.label += " --way-predict";
+        if (params.interconnect != "bus")
+            workload.label += " --interconnect " + params.interconnect;
+        if (params.threadsPerCore > 1)
+            workload.label += " --smt 2 --smt-policy " + params.smtPolicy;
+        if (params.pageMapping != "identity")
+            workload.label += " --page-map " + params.pageMapping;
+        if (params.tlbEntries > 0)
+            workload.label += " --tlb " + std::to_string(params.tlbEntries);
+    }
+
+    // A few hot shared blocks (coherence traffic), private strided walks and
+    // random accesses. With SMT the first thread of a core also reads two
+    // blocks that its store-heavy sibling threads keep writing (producer and
+    // consumer threads), so sibling stores meet its misses in the shared L1
+    // and store buffer.
+    workload.streams.resize(params.numCores * params.threadsPerCore);
+    for (size_t stream = 0; stream < workload.streams.size(); ++stream)
+    {
+        bool producer = stream % params.threadsPerCore != 0;
+        uint64_t siblingBase = 0x4000000ULL + 0x10000ULL * (stream / params.threadsPerCore);
+        uint64_t privateBase = 0x100000ULL * (stream + 1);
+        uint64_t stride = 4ULL << random.below(5);
+        for (long long int i = 0; i < accesses; ++i)
+        {
+            uint64_t kind = random.below(100);
+            TraceEntry entry = {random.below(100) < (producer ? 80 : 30), 0, 0, -1, 0};
+            if (kind < 40)
+                entry.address = 0x8000000ULL + random.below(64) * 64 + random.below(16) * 4;
+            else if (kind < 55 && params.threadsPerCore > 1)
+            {
+                entry.address = siblingBase + random.below(2) * 64;
+                entry.isWrite = producer;
+            }
+            else if (kind < 70)
+                entry.address = privateBase + (i * stride) % 0x10000;
+            else
+                entry.address = random.below(1 << 20) * 4;
+            if (random.below(10) == 0)
+                entry.gap = 1 + static_cast<uint32_t>(random.below(3));
+            workload.streams[stream].push_back(entry);
+        }
+    }
+    return workload;
+}
+
+void printUsage()
+{
+    std::cout << "Usage: ./L1validate [options]\n"
+              << "Runs every engine on the same workloads and checks that each reproduces the\n"
+              << "reference loop exactly (per-core CacheStats, BusStats, final cycle) and that\n"
+              << "every run, the reference included, retires each trace entry exactly once.\n"
+              << "Options:\n"
+              << "  --cases <n>     : random synthetic cases (default 20)\n"
+              << "  --seed <n>      : seed of the case generator (default 1)\n"
+              << "  --accesses <n>  : accesses per synthetic trace (default 500)\n"
+              << "  --plain         : only vary -s/-E/-b/-n, leave MSHRs, prefetchers, SMT, TLBs etc. off\n"
+              << "  --engine <name> : only check this engine against the reference\n"
+              << "  -t <tracefile>  : validate on <tracefile>_procN.trace instead, with\n"
+              << "  -s <s> -E <E> -b <b> -n <cores> --smt <n>: its geometry (L1simulate defaults)\n"
+              << "  --mshrs <n> --sb <n>: and its MSHRs and store buffer (default 0)\n"
+              << "  --prefetch <p> --victim <n>: and its prefetcher and victim cache (default none)\n"
+              << "  -v              : list every case\n"
+              << "  -h              : print this help\n";
+}
+
+int main(int argc, char *argv[])
+{
+    long long int cases = 20;
+    uint64_t seed = 1;
+    long long int accesses = 500;
+    bool plain = false;
+    bool verbose = false;
+    std::string onlyEngine;
+    std::string traceName;
+    SimulationParams traceParams;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--cases") == 0 && i + 1 < argc)
+            cases = atoll(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            seed = strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--accesses") == 0 && i + 1 < argc)
+            accesses = atoll(argv[++i]);
+        else if (strcmp(argv[i], "--plain") == 0)
+            plain = true;
+        else if (strcmp(argv[i], "--engine") == 0 && i + 1 < argc)
+            onlyEngine = argv[++i];
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+            traceName = argv[++i];
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+            traceParams.setIndexBits = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-E") == 0 && i + 1 < argc)
+            traceParams.associativity = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc)
+            traceParams.blockBits = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            traceParams.numCores = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--smt") == 0 && i + 1 < argc)
+            traceParams.threadsPerCore = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--mshrs") == 0 && i + 1 < argc)
+            traceParams.mshrs = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--sb") == 0 && i + 1 < argc)
+            traceParams.storeBufferDepth = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--prefetch") == 0 && i + 1 < argc)
+            traceParams.prefetcher = argv[++i];
+        else if (strcmp(argv[i], "--victim") == 0 && i + 1 < argc)
+            traceParams.victimEntries = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-v") == 0)
+            verbose = true;
+        else if (strcmp(argv[i], "-h") == 0)
+        {
+            printUsage();
+            return 0;
+        }
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    std::vector<const Engine *> checked;
+    for (size_t e = 1; e < engineCount; ++e)
+    {
+        if (onlyEngine.empty() || onlyEngine == engines[e].name)
+            checked.push_back(&engines[e]);
+    }
+    if (checked.empty())
+    {
+        std::cerr << "Error: Unknown engine " << onlyEngine << std::endl;
+        return 1;
+    }
+    if (cases <= 0 || accesses <= 0)
+    {
+        std::cerr << "Error: Cases and accesses must be positive" << std::endl;
+        return 1;
+    }
+    if (traceParams.setIndexBits < 0 || traceParams.associativity <= 0 || traceParams.blockBits < 2 ||
+        traceParams.numCores <= 0 || traceParams.threadsPerCore <= 0 || traceParams.threadsPerCore > 64 ||
+        traceParams.mshrs < 0 || traceParams.storeBufferDepth < 0 || traceParams.victimEntries < 0)
+    {
+        std::cerr << "Error: Invalid cache geometry, core, thread, MSHR, store buffer or victim cache count" << std::endl;
+        return 1;
+    }
+    if (traceParams.prefetcher != "none" && !isKnownPrefetcher(traceParams.prefetcher))
+    {
+        std::cerr << "Error: Unknown prefetcher " << traceParams.prefetcher << std::endl;
+        return 1;
+    }
+
+    std::vector<Workload> workloads;
+    if (!traceName.empty())
+    {
+        Workload workload;
+        workload.params = traceParams;
+        workload.label = traceName;
+        workload.streams.resize(traceParams.numCores * traceParams.threadsPerCore);
+        for (size_t stream = 0; stream < workload.streams.size(); ++stream)
+        {
+            if (!readTraceFile(traceName + "_proc" + std::to_string(stream) + ".trace", workload.streams[stream]))
+                return 1;
+        }
+        workloads.push_back(workload);
+    }
+    else
+    {
+        for (long long int c = 0; c < cases; ++c)
+            workloads.push_back(syntheticCase(seed, c, accesses, plain));
+    }
+
+    // Per engine: seconds, simulated accesses and cycles over all cases, failed cases
+    std::vector<double> seconds(engineCount, 0.0);
+    std::vector<uint64_t> simulatedAccesses(engineCount, 0), simulatedCycles(engineCount, 0);
+    std::vector<long long int> failures(engineCount, 0);
+    for (size_t w = 0; w < workloads.size(); ++w)
+    {
+        const Workload &workload = workloads[w];
+        Observation expected = observe(engines[0], workload, UINT64_MAX);
+        std::vector<std::string> violations = checkInvariants(workload, expected);
+        if (!violations.empty())
+        {
+            failures[0]++;
+            printFailure("INVARIANT", engines[0], w, workload, std::to_string(violations.size()) + " violated", violations);
+        }
+        uint64_t caseAccesses = 0;
+        for (uint64_t count : expected.instructions)
+            caseAccesses += count;
+        seconds[0] += expected.seconds;
+        simulatedAccesses[0] += caseAccesses;
+        simulatedCycles[0] += expected.cycle;
+        if (verbose)
+            std::cout << "case " << w << ": " << workload.label << ", " << expected.cycle << " cycles\n";
+
+        for (const Engine *engine : checked)
+        {
+            size_t e = engine - engines;
+            Observation actual = observe(*engine, workload, UINT64_MAX);
+            seconds[e] += actual.seconds;
+            simulatedAccesses[e] += caseAccesses;
+            simulatedCycles[e] += expected.cycle;
+            if (!actual.error.empty())
+            {
+                failures[e]++;
+                printFailure("ERROR", *engine, w, workload, actual.error, std::vector<std::string>());
+                continue;
+            }
+            violations = checkInvariants(workload, actual);
+            std::vector<std::string> differences = compare(expected, actual);
+            if (!violations.empty())
+            {
+                printFailure("INVARIANT", *engine, w, workload, std::to_string(violations.size()) + " violated", violations);
+            }
+            if (!differences.empty())
+            {
+                uint64_t cycle = bisect(*engine, workload, std::max(expected.cycle, actual.cycle));
+                printFailure("MISMATCH", *engine, w, workload,
+                             std::to_string(differences.size()) + " counters differ at the end, first divergence in cycle " +
+                                 std::to_string(cycle - 1) + " (reference vs " + engine->name + "):",
+                             compare(observe(engines[0], workload, cycle), observe(*engine, workload, cycle)));
+            }
+            if (!violations.empty() || !differences.empty())
+                failures[e]++;
+        }
+    }
+
+    std::cout << "\nValidated " << workloads.size() << " case(s)\n";
+    std::cout << std::left << std::setw(12) << "Engine" << std::right << std::setw(10) << "Failures" << std::setw(14)
+              << "Accesses/s" << std::setw(14) << "Cycles/s" << std::setw(10) << "Speedup" << "  Description\n";
+    bool passed = true;
+    for (size_t e = 0; e < engineCount; ++e)
+    {
+        if (e > 0 && std::find(checked.begin(), checked.end(), &engines[e]) == checked.end())
+            continue;
+        passed &= failures[e] == 0;
+        double time = seconds[e] > 0 ? seconds[e] : 1e-9;
+        std::cout << std::left << std::setw(12) << engines[e].name << std::right << std::setw(10)
+                  << failures[e] << std::fixed << std::setprecision(0)
+                  << std::setw(14) << simulatedAccesses[e] / time << std::setw(14) << simulatedCycles[e] / time
+                  << std::setprecision(2) << std::setw(9) << seconds[0] / time << "x  " << engines[e].description << "\n";
+    }
+    std::cout << (passed ? "PASS" : "FAIL") << "\n";
+    return passed ? 0 : 1;
+}